@@ -0,0 +1,108 @@
+#include "src/plotter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+using namespace std;
+
+// Waits until `path` is completely written, i.e. `trailer` is among its last bytes; gives up after a minute.
+bool wait_written(const char *path, const char *trailer)
+{
+    const auto deadline = chrono::steady_clock::now() + chrono::seconds(60);
+    while (chrono::steady_clock::now() < deadline)
+    {
+        FILE *fin = fopen(path, "rb");
+        if (fin)
+        {
+            char tail[64];
+            fseek(fin, 0, SEEK_END);
+            long size = ftell(fin);
+            fseek(fin, max(0L, size - static_cast<long>(sizeof(tail))), SEEK_SET);
+            size_t n = fread(tail, 1, sizeof(tail), fin);
+            fclose(fin);
+            if (search(tail, tail + n, trailer, trailer + strlen(trailer)) != tail + n)
+                return true;
+        }
+        this_thread::sleep_for(chrono::microseconds(200));
+    }
+    return false;
+}
+
+// Renders one line plot with a transparent band on a running Plotter and returns the wall time in milliseconds,
+// until gnuplot has finished writing the output. Pointing gnuplot at /dev/null afterwards closes the file.
+double render(Plotter &plt, const vector<double> &y, const vector<double> &ub, const vector<double> &lb, const char *path, const char *trailer)
+{
+    unlink(path);
+    auto start = chrono::steady_clock::now();
+    plt.set_savePath(path);
+    plt.createPlot(y, "signal");
+    plt.fillBetween(ub, lb);
+    plt.plot();
+    plt.set_savePath("/dev/null");
+    plt.plot();
+    if (!wait_written(path, trailer))
+        return NAN;
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    const struct
+    {
+        const char *name;
+        Plotter::Terminal terminal;
+        Plotter::Backend backend;
+        const char *path;
+        const char *trailer;
+    } terminals[] = {
+        {"pngcairo", Plotter::PNGCAIRO, Plotter::GNUPLOT, "bench.png", "IEND"},
+        {"png", Plotter::PNG, Plotter::GNUPLOT, "bench.png", "IEND"},
+        {"draft", Plotter::DRAFT, Plotter::GNUPLOT, "bench.png", "IEND"},
+        {"svg", Plotter::SVG, Plotter::GNUPLOT, "bench.svg", "</svg>"},
+        {"pdfcairo", Plotter::PDFCAIRO, Plotter::GNUPLOT, "bench.pdf", "%%EOF"},
+        {"native", Plotter::PNGCAIRO, Plotter::NATIVE, "bench.png", "IEND"},
+    };
+    const int sizes[][2] = {{800, 600}, {1200, 900}, {1920, 1080}};
+    const int points[] = {1000, 100000};
+    const int repeats = 3;
+
+    // "first" is the first figure of a new Plotter, including starting gnuplot and loading its fonts;
+    // "ms/plot" is the best of the following figures, rendered by the same, warm gnuplot
+    printf("%-10s %-10s %8s %10s %10s\n", "terminal", "size", "points", "first", "ms/plot");
+    for (int n : points)
+    {
+        vector<double> y(n), ub(n), lb(n);
+        for (int i = 0; i < n; i++)
+        {
+            y[i] = sin(i * 20.0 / n) + 0.1 * sin(i * 0.5);
+            ub[i] = y[i] + 0.2;
+            lb[i] = y[i] - 0.2;
+        }
+
+        for (const auto &size : sizes)
+            for (const auto &t : terminals)
+            {
+                auto start = chrono::steady_clock::now();
+                Plotter plt(size[0], size[1], 12, false, t.backend);
+                plt.set_terminal(t.terminal);
+                const bool warm = !std::isnan(render(plt, y, ub, lb, t.path, t.trailer));
+                const double first = warm ? chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() : NAN;
+                double best = NAN;
+                for (int r = 0; r < repeats; r++)
+                {
+                    const double ms = render(plt, y, ub, lb, t.path, t.trailer);
+                    if (std::isnan(best) || ms < best)
+                        best = ms;
+                }
+                printf("%-10s %4dx%-5d %8d %10.1f %10.1f\n", t.name, size[0], size[1], n, first, best);
+            }
+    }
+
+    unlink("bench.png");
+    unlink("bench.svg");
+    unlink("bench.pdf");
+    return 0;
+}
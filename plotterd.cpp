@@ -0,0 +1,53 @@
+#include "src/render_daemon.hpp"
+
+#include <iostream>
+
+// Render daemon for Plotter(..., Plotter::DAEMON) clients; runs until SIGINT or SIGTERM.
+// Usage: plotterd [-n <workers>] [-s <socket>] [-t <timeout_ms>] [-w <wait_ms>]
+int main(int argc, char **argv)
+{
+    int n_workers = 4, timeout_ms = 60000, wait_ms = 5000;
+    std::string socket_path = Plotter::daemonSocket();
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc)
+            n_workers = atoi(argv[++i]);
+        else if (arg == "-s" && i + 1 < argc)
+            socket_path = argv[++i];
+        else if (arg == "-t" && i + 1 < argc)
+            timeout_ms = atoi(argv[++i]);
+        else if (arg == "-w" && i + 1 < argc)
+            wait_ms = atoi(argv[++i]);
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [-n <workers>] [-s <socket>] [-t <timeout_ms>] [-w <wait_ms>]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Signals are taken by sigwait() below rather than interrupting the daemon's threads
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try
+    {
+        RenderDaemon daemon(socket_path.c_str(), n_workers, timeout_ms, wait_ms);
+        std::cerr << "plotterd: " << n_workers << " gnuplot workers on " << socket_path << std::endl;
+        std::thread server([&]
+                           { daemon.run(); });
+        int signal;
+        sigwait(&signals, &signal);
+        daemon.stop();
+        server.join();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
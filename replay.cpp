@@ -0,0 +1,29 @@
+#include "src/plotter.hpp"
+
+#include <iostream>
+
+// Renders plot bundles written by Plotter::saveBundle().
+// Usage: replay <bundle> [<bundle> ...]
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <bundle> [<bundle> ...]" << std::endl;
+        return 1;
+    }
+
+    int failed = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        try
+        {
+            Plotter::replayBundle(argv[i]);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << argv[i] << ": " << e.what() << std::endl;
+            failed++;
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}
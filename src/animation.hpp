@@ -0,0 +1,402 @@
+// ****************************
+// * Author: Abhinav Barnwal
+// * URL: https://github.com/barnawalabhinav/cppplotlib
+// * This code is a part of the project "cppplotlib" which is a simple C++ wrapper for gnuplot.
+// * The project is licensed under MIT License.
+// ****************************
+
+#pragma once
+
+#include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "plotter.hpp"
+
+/**
+ * @brief Renders a sequence of frames that share one static layout
+ * @note 1. Settings and series styles are sent once per worker; each frame only sends the series that changed since the previous frame
+ * @note 2. Frames are serialized on background threads, so pushFrame() returns while earlier frames are still rendering
+ * @note 3. With several workers, frames render out of order on separate gnuplot processes but are written to their own numbered files
+ */
+class Animation
+{
+public:
+    enum Format
+    {
+        PNG_SEQUENCE, // 0
+        GIF,          // 1
+        WEBP,         // 2
+    };
+
+private:
+    struct SeriesData
+    {
+        std::vector<double> x;
+        std::vector<double> y;
+    };
+
+    struct Job
+    {
+        bool is_frame = false;
+        int index = 0;
+        std::string command;
+        std::vector<std::shared_ptr<const SeriesData>> series;
+        std::vector<long> versions;
+    };
+
+    struct Worker
+    {
+        FILE *pipe = nullptr;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Job> queue;
+        std::vector<long> sent_versions;
+        bool done = false;
+    };
+
+    static const int max_queued_frames = 4;
+
+    Format format;
+    std::string output;
+    std::string frame_prefix, frame_conversion, frame_suffix;
+    bool debug = false;
+    bool finished = false;
+    int cnt_frames = 0;
+    std::string plot_clause;
+    std::vector<std::shared_ptr<const SeriesData>> series;
+    std::vector<long> versions;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    /**
+     * @brief Queues a job on a worker, blocking while the worker is too far behind
+     */
+    inline void _enqueue(Worker &worker, Job job)
+    {
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.cv.wait(lock, [&]
+                       { return static_cast<int>(worker.queue.size()) < max_queued_frames; });
+        worker.queue.push_back(std::move(job));
+        worker.cv.notify_all();
+    }
+
+    /**
+     * @brief Writes the data of one series as a gnuplot datablock
+     */
+    inline static void _write_datablock(FILE *pipe, const int index, const SeriesData &data)
+    {
+        fprintf(pipe, "$s%d << EOD\n", index);
+        char line[64];
+        for (size_t i = 0; i < data.x.size() && i < data.y.size(); i++)
+        {
+            int len = snprintf(line, sizeof(line), "%.10g %.10g\n", data.x[i], data.y[i]);
+            fwrite(line, 1, len, pipe);
+        }
+        fprintf(pipe, "EOD\n");
+    }
+
+    /**
+     * @brief Splits a PNG sequence pattern around its frame number conversion, unescaping "%%"
+     * @return false unless the pattern has exactly one conversion of the form %d, %5d or %05d and no other '%'
+     */
+    inline static bool _split_pattern(const std::string &pattern, std::string &prefix, std::string &conversion, std::string &suffix)
+    {
+        prefix.clear();
+        conversion.clear();
+        suffix.clear();
+        for (size_t i = 0; i < pattern.size(); i++)
+        {
+            std::string &text = conversion.empty() ? prefix : suffix;
+            if (pattern[i] != '%')
+                text += pattern[i];
+            else if (i + 1 < pattern.size() && pattern[i + 1] == '%')
+                text += pattern[++i];
+            else
+            {
+                size_t end = i + 1;
+                while (end < pattern.size() && isdigit(static_cast<unsigned char>(pattern[end])))
+                    end++;
+                // At most three digits of zero flag and width
+                if (!conversion.empty() || end - i > 4 || end >= pattern.size() || pattern[end] != 'd')
+                    return false;
+                conversion = pattern.substr(i, end + 1 - i);
+                i = end;
+            }
+        }
+        return !conversion.empty();
+    }
+
+    /**
+     * @brief Worker loop: serializes queued frames into the worker's gnuplot process
+     */
+    inline void _run(Worker &worker)
+    {
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(worker.mutex);
+                worker.cv.wait(lock, [&]
+                               { return !worker.queue.empty() || worker.done; });
+                if (worker.queue.empty())
+                    return;
+                job = std::move(worker.queue.front());
+                worker.queue.pop_front();
+                worker.cv.notify_all();
+            }
+
+            if (!job.is_frame)
+            {
+                fprintf(worker.pipe, "%s\n", job.command.c_str());
+                continue;
+            }
+
+            worker.sent_versions.resize(job.versions.size(), -2);
+            for (size_t i = 0; i < job.series.size(); i++)
+            {
+                if (worker.sent_versions[i] == job.versions[i])
+                    continue;
+                _write_datablock(worker.pipe, i, *job.series[i]);
+                worker.sent_versions[i] = job.versions[i];
+            }
+
+            if (format == PNG_SEQUENCE)
+            {
+                char number[32];
+                snprintf(number, sizeof(number), frame_conversion.c_str(), job.index);
+                fprintf(worker.pipe, "set output '%s%s%s'\n", frame_prefix.c_str(), number, frame_suffix.c_str());
+            }
+            fprintf(worker.pipe, "%s", job.command.c_str());
+            fprintf(worker.pipe, "plot %s\n", plot_clause.c_str());
+            fflush(worker.pipe);
+        }
+    }
+
+public:
+    /**
+     *  @brief  Constructor
+     *  @param  output: output path; for Animation::PNG_SEQUENCE it must contain one integer conversion for the frame number, e.g. "frames/%05d.png", and "%%" for any literal '%'
+     *  @param  format: output format; See Animation::Format for options
+     *  @param  n_workers: number of gnuplot processes rendering frames; forced to 1 for Animation::GIF and Animation::WEBP
+     *  @param  size_x: width of the frames in pixels
+     *  @param  size_y: height of the frames in pixels
+     *  @param  fontSize: font size to be used in the frames
+     *  @param  delay_ms: delay between frames of an animated GIF or WebP in milliseconds
+     *  @param  debugMode: if true, writes the gnuplot commands of worker `k` to "debug_animation_k.txt" instead of executing them
+     *  @note  `output` is not a string, it is a char array; use string.c_str() to convert a string to char array
+     */
+    inline Animation(const char *output, const Format format = PNG_SEQUENCE, int n_workers = 1, int size_x = 1200, int size_y = 900, int fontSize = 20, int delay_ms = 40, bool debugMode = false)
+        : format(format), output(output), debug(debugMode)
+    {
+        if (format == PNG_SEQUENCE && !_split_pattern(output, frame_prefix, frame_conversion, frame_suffix))
+            throw std::runtime_error("ERROR: PNG sequence output needs one frame number pattern, e.g. \"frame_%05d.png\", and \"%%\" for a literal '%'!");
+        if (format != PNG_SEQUENCE || n_workers < 1)
+            n_workers = 1;
+
+        workers.reserve(n_workers);
+        for (int k = 0; k < n_workers; k++)
+        {
+            std::unique_ptr<Worker> worker(new Worker());
+            if (debugMode)
+                worker->pipe = fopen(("debug_animation_" + std::to_string(k) + ".txt").c_str(), "w");
+            else
+                worker->pipe = popen("gnuplot", "w");
+            if (!worker->pipe)
+            {
+                // The workers already started must be joined before their threads are destroyed
+                finish();
+                throw std::runtime_error("ERROR: Could not set up pipe with gnuplot!");
+            }
+
+            if (format == GIF)
+                fprintf(worker->pipe, "set terminal gif animate delay %d loop 0 font ',%d' size %d, %d\nset output '%s'\n", std::max(1, delay_ms / 10), fontSize, size_x, size_y, output);
+            else if (format == WEBP)
+                fprintf(worker->pipe, "set terminal webp animate delay %d loop 0 font ',%d' size %d, %d\nset output '%s'\n", delay_ms, fontSize, size_x, size_y, output);
+            else
+                fprintf(worker->pipe, "set terminal pngcairo enhanced font ',%d' size %d, %d\n", fontSize, size_x, size_y);
+
+            Worker *w = worker.get();
+            try
+            {
+                worker->thread = std::thread([this, w]
+                                             { _run(*w); });
+            }
+            catch (...)
+            {
+                if (debugMode)
+                    fclose(worker->pipe);
+                else
+                    pclose(worker->pipe);
+                finish();
+                throw;
+            }
+            workers.push_back(std::move(worker));
+        }
+    }
+
+    /**
+     *  @brief  Destructor; waits for all queued frames to be rendered
+     */
+    inline virtual ~Animation()
+    {
+        finish();
+    }
+
+    /**
+     * @brief Sends a static gnuplot setting shared by all frames, e.g. "set grid" or "set xrange [0:10]"
+     * @param command: gnuplot command
+     * @note `command` is not a string, it is a char array; use string.c_str() to convert a string to char array
+     */
+    inline void set(const char *command)
+    {
+        Job job;
+        job.command = command;
+        for (auto &worker : workers)
+            _enqueue(*worker, job);
+    }
+
+    /**
+     * @brief Sets x-axis range of all frames
+     * @param min: minimum value of the x-axis
+     * @param max: maximum value of the x-axis
+     */
+    inline void set_xlim(double min, double max)
+    {
+        set(("set xrange [" + std::to_string(min) + ":" + std::to_string(max) + "]").c_str());
+    }
+
+    /**
+     * @brief Sets y-axis range of all frames
+     * @param min: minimum value of the y-axis
+     * @param max: maximum value of the y-axis
+     */
+    inline void set_ylim(double min, double max)
+    {
+        set(("set yrange [" + std::to_string(min) + ":" + std::to_string(max) + "]").c_str());
+    }
+
+    /**
+     * @brief Adds a line series to the static layout
+     * @param line_title: title of the line plot
+     * @param line_color: color of the line plot
+     * @param marker: point marker style; See Plotter::MarkerStyle for options
+     * @param point_size: point marker size; Only relevant if marker is not Plotter::None
+     * @param line_width: Width of the plotted line
+     * @param line_style: line style; See Plotter::LineStyle for options
+     * @return index of the series, to be passed to setSeries()
+     * @note `line_title` and `line_color` are not strings, they are char arrays; use string.c_str() to convert a string to char array
+     */
+    inline int addSeries(const char *line_title = "", const char *line_color = "auto", const Plotter::MarkerStyle marker = Plotter::None, const double point_size = 1.0, const double line_width = 1.0, const Plotter::LineStyle line_style = Plotter::SOLID)
+    {
+        if (cnt_frames > 0)
+            throw std::runtime_error("ERROR: Animation series must be added before the first frame!");
+
+        char clause[512];
+        int index = series.size();
+        if (std::string(line_color) == "auto")
+            snprintf(clause, sizeof(clause), "$s%d using 1:2 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", index, marker, point_size, line_style, line_width, line_title);
+        else
+            snprintf(clause, sizeof(clause), "$s%d using 1:2 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", index, marker, point_size, line_style, line_width, line_color, line_title);
+
+        if (!plot_clause.empty())
+            plot_clause += ", ";
+        plot_clause += clause;
+
+        series.push_back(std::make_shared<const SeriesData>());
+        versions.push_back(-1);
+        return index;
+    }
+
+    /**
+     * @brief Updates the data of a series from the next frame on
+     * @tparam T1: type of the x-axis values
+     * @tparam T2: type of the y-axis values
+     * @param index: index of the series returned by addSeries()
+     * @param x: vector of x-axis values
+     * @param y: vector of y-axis values
+     * @note Series that are not updated keep their data and are not sent again
+     * @overload
+     */
+    template <typename T1, typename T2>
+    inline void setSeries(const int index, const std::vector<T1> &x, const std::vector<T2> &y)
+    {
+        if (index < 0 || index >= static_cast<int>(series.size()))
+            throw std::runtime_error("ERROR: Animation series index out of range!");
+
+        std::shared_ptr<SeriesData> data = std::make_shared<SeriesData>();
+        data->x.assign(x.begin(), x.end());
+        data->y.assign(y.begin(), y.end());
+        series[index] = data;
+        versions[index] = cnt_frames;
+    }
+
+    /**
+     * @brief Updates the data of a series from the next frame on
+     * @tparam T2: type of the y-axis values
+     * @param index: index of the series returned by addSeries()
+     * @param y: vector of y-axis values, plotted against their indices
+     * @overload
+     */
+    template <typename T2>
+    inline void setSeries(const int index, const std::vector<T2> &y)
+    {
+        std::vector<int> x(y.size());
+        for (int i = 0; i < static_cast<int>(y.size()); i++)
+            x[i] = i;
+        setSeries(index, x, y);
+    }
+
+    /**
+     * @brief Renders a frame from the current data of all series
+     * @param title: title of the frame, e.g. the simulation time
+     * @note `title` is not a string, it is a char array; use string.c_str() to convert a string to char array
+     */
+    inline void pushFrame(const char *title = "")
+    {
+        if (finished)
+            throw std::runtime_error("ERROR: Animation is already finished!");
+        if (series.empty())
+            throw std::runtime_error("ERROR: Animation has no series!");
+
+        Job job;
+        job.is_frame = true;
+        job.index = cnt_frames;
+        job.command = std::string("set title '") + title + "'\n";
+        job.series = series;
+        job.versions = versions;
+        _enqueue(*workers[cnt_frames % workers.size()], std::move(job));
+        cnt_frames++;
+    }
+
+    /**
+     * @brief Waits for all queued frames to be rendered and closes the output
+     */
+    inline void finish()
+    {
+        if (finished)
+            return;
+        finished = true;
+
+        for (auto &worker : workers)
+        {
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->done = true;
+            }
+            worker->cv.notify_all();
+            worker->thread.join();
+
+            if (format != PNG_SEQUENCE)
+                fprintf(worker->pipe, "unset output\n");
+            fflush(worker->pipe);
+            if (debug)
+                fclose(worker->pipe);
+            else
+                pclose(worker->pipe);
+        }
+    }
+};
@@ -0,0 +1,827 @@
+// ****************************
+// * Author: Abhinav Barnwal
+// * URL: https://github.com/barnawalabhinav/cppplotlib
+// * This code is a part of the project "cppplotlib" which is a simple C++ wrapper for gnuplot.
+// * The project is licensed under MIT License.
+// ****************************
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @brief In-process rasterizer for simple 2D line, scatter and filled band figures
+ * @note 1. Draws anti-aliased lines, axes with ticks, grid, labels and a legend into an RGBA buffer and encodes it as PNG without any external process or library
+ * @note 2. Text uses a built-in 5x7 bitmap font scaled to the requested font size
+ * @note 3. Used by Plotter when constructed with Plotter::NATIVE; Plotter falls back to gnuplot for anything this class cannot draw
+ */
+class NativeRenderer
+{
+public:
+    enum SeriesKind
+    {
+        LINE,    // 0
+        SCATTER, // 1
+        FILL,    // 2
+    };
+
+    enum Marker
+    {
+        NO_MARKER, // 0
+        PLUS,      // 1
+        CROSS,     // 2
+        BOX,       // 3
+        BOX_F,     // 4
+        CIRCLE,    // 5
+        CIRCLE_F,  // 6
+        GLYPH,     // 7
+    };
+
+    struct Series
+    {
+        SeriesKind kind = LINE;
+        std::string filename;
+        std::string title;
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<double> y2;
+        uint32_t color = 0;
+        bool auto_color = true;
+        Marker marker = NO_MARKER;
+        char glyph = 'O';
+        double point_size = 1.0;
+        double line_width = 1.0;
+        double alpha = 1.0;
+    };
+
+    int width = 1200;
+    int height = 900;
+    int font_size = 20;
+    std::string title;
+    std::string xlabel;
+    std::string ylabel;
+    bool grid = false;
+    bool legend = true;
+    bool legend_box = false;
+    bool legend_left = false;
+    bool has_xlim = false;
+    bool has_ylim = false;
+    double xmin = 0.0, xmax = 1.0;
+    double ymin = 0.0, ymax = 1.0;
+    std::vector<Series> series;
+
+private:
+    std::vector<uint8_t> rgba;
+    int clip_x0 = 0, clip_y0 = 0, clip_x1 = 0, clip_y1 = 0;
+
+    /**
+     * @brief Returns the 5x7 glyph of a printable ASCII character, one byte per column with bit 0 at the top
+     */
+    inline static const uint8_t *_glyph(char c)
+    {
+        static const uint8_t font[95][5] = {
+            {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00}, {0x14, 0x7F, 0x14, 0x7F, 0x14},
+            {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62}, {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00},
+            {0x00, 0x1C, 0x22, 0x41, 0x00}, {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x08, 0x2A, 0x1C, 0x2A, 0x08}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+            {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00}, {0x20, 0x10, 0x08, 0x04, 0x02},
+            {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00}, {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31},
+            {0x18, 0x14, 0x12, 0x7F, 0x10}, {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},
+            {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00}, {0x00, 0x56, 0x36, 0x00, 0x00},
+            {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14}, {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06},
+            {0x32, 0x49, 0x79, 0x41, 0x3E}, {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+            {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x01, 0x01}, {0x3E, 0x41, 0x41, 0x51, 0x32},
+            {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00}, {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41},
+            {0x7F, 0x40, 0x40, 0x40, 0x40}, {0x7F, 0x02, 0x04, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+            {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46}, {0x46, 0x49, 0x49, 0x49, 0x31},
+            {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F}, {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x7F, 0x20, 0x18, 0x20, 0x7F},
+            {0x63, 0x14, 0x08, 0x14, 0x63}, {0x03, 0x04, 0x78, 0x04, 0x03}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x00},
+            {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7F, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04}, {0x40, 0x40, 0x40, 0x40, 0x40},
+            {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78}, {0x7F, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20},
+            {0x38, 0x44, 0x44, 0x48, 0x7F}, {0x38, 0x54, 0x54, 0x54, 0x18}, {0x08, 0x7E, 0x09, 0x01, 0x02}, {0x08, 0x14, 0x54, 0x54, 0x3C},
+            {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x44, 0x3D, 0x00}, {0x00, 0x7F, 0x10, 0x28, 0x44},
+            {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x18, 0x04, 0x78}, {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38},
+            {0x7C, 0x14, 0x14, 0x14, 0x08}, {0x08, 0x14, 0x14, 0x18, 0x7C}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},
+            {0x04, 0x3F, 0x44, 0x40, 0x20}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C}, {0x3C, 0x40, 0x30, 0x40, 0x3C},
+            {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0C, 0x50, 0x50, 0x50, 0x3C}, {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00},
+            {0x00, 0x00, 0x7F, 0x00, 0x00}, {0x00, 0x41, 0x36, 0x08, 0x00}, {0x08, 0x04, 0x08, 0x10, 0x08},
+        };
+        if (c < 32 || c > 126)
+            c = '?';
+        return font[c - 32];
+    }
+
+    /**
+     * @brief Blends a color onto a pixel with the given coverage, honouring the clip rectangle
+     */
+    inline void _blend(int px, int py, uint32_t color, double coverage)
+    {
+        if (px < clip_x0 || px >= clip_x1 || py < clip_y0 || py >= clip_y1 || coverage <= 0.0)
+            return;
+        double a = std::min(1.0, coverage) * ((color & 0xff) / 255.0);
+        uint8_t *p = &rgba[(static_cast<size_t>(py) * width + px) * 4];
+        for (int c = 0; c < 3; c++)
+        {
+            int target = (color >> (24 - 8 * c)) & 0xff;
+            p[c] = static_cast<uint8_t>(p[c] + (target - p[c]) * a + 0.5);
+        }
+    }
+
+    /**
+     * @brief Draws an anti-aliased line segment of the given width
+     * @note Only pixels within half a pixel of the segment outline are visited, so the cost is proportional to length times width
+     */
+    inline void _line(double x0, double y0, double x1, double y1, double line_width, uint32_t color)
+    {
+        if (!std::isfinite(x0) || !std::isfinite(y0) || !std::isfinite(x1) || !std::isfinite(y1))
+            return;
+        const double hw = std::max(0.5, line_width / 2.0);
+        const double dx = x1 - x0, dy = y1 - y0;
+        const double len2 = dx * dx + dy * dy;
+        const bool steep = std::fabs(dy) > std::fabs(dx);
+        const double reach = hw + 1.0;
+
+        auto coverage = [&](double px, double py)
+        {
+            double t = len2 > 0.0 ? ((px - x0) * dx + (py - y0) * dy) / len2 : 0.0;
+            t = std::max(0.0, std::min(1.0, t));
+            double ex = x0 + t * dx - px, ey = y0 + t * dy - py;
+            return hw + 0.5 - std::sqrt(ex * ex + ey * ey);
+        };
+
+        double major0 = steep ? std::min(y0, y1) : std::min(x0, x1);
+        double major1 = steep ? std::max(y0, y1) : std::max(x0, x1);
+        int lo = std::max(static_cast<int>(std::floor(major0 - reach)), steep ? clip_y0 : clip_x0);
+        int hi = std::min(static_cast<int>(std::ceil(major1 + reach)), (steep ? clip_y1 : clip_x1) - 1);
+        const double slope = steep ? (dy != 0.0 ? dx / dy : 0.0) : (dx != 0.0 ? dy / dx : 0.0);
+        const double spread = reach * std::sqrt(1.0 + slope * slope);
+        for (int m = lo; m <= hi; m++)
+        {
+            double mc = std::max(major0, std::min(major1, m + 0.5));
+            double center = steep ? x0 + (mc - y0) * slope : y0 + (mc - x0) * slope;
+            int n0 = static_cast<int>(std::floor(center - spread));
+            int n1 = static_cast<int>(std::ceil(center + spread));
+            for (int n = n0; n <= n1; n++)
+            {
+                int px = steep ? n : m, py = steep ? m : n;
+                _blend(px, py, color, coverage(px + 0.5, py + 0.5));
+            }
+        }
+    }
+
+    /**
+     * @brief Fills an axis-aligned rectangle
+     */
+    inline void _rect(int x0, int y0, int x1, int y1, uint32_t color)
+    {
+        for (int py = std::max(y0, clip_y0); py < std::min(y1, clip_y1); py++)
+            for (int px = std::max(x0, clip_x0); px < std::min(x1, clip_x1); px++)
+                _blend(px, py, color, 1.0);
+    }
+
+    /**
+     * @brief Draws an anti-aliased circle, filled or as an outline
+     */
+    inline void _circle(double cx, double cy, double r, double line_width, bool filled, uint32_t color)
+    {
+        for (int py = static_cast<int>(std::floor(cy - r - 1)); py <= static_cast<int>(std::ceil(cy + r + 1)); py++)
+            for (int px = static_cast<int>(std::floor(cx - r - 1)); px <= static_cast<int>(std::ceil(cx + r + 1)); px++)
+            {
+                double d = std::hypot(px + 0.5 - cx, py + 0.5 - cy);
+                double c = filled ? r + 0.5 - d : line_width / 2.0 + 0.5 - std::fabs(d - r);
+                _blend(px, py, color, c);
+            }
+    }
+
+    /**
+     * @brief Draws text with the bitmap font
+     * @param align: -1 to left align at x, 0 to center on x, 1 to right align at x
+     * @param vertical: if true, the text runs bottom to top and `y` is its center
+     */
+    inline void _text(const std::string &text, int x, int y, int scale, int align, uint32_t color, bool vertical = false)
+    {
+        int length = static_cast<int>(text.size()) * 6 * scale - scale;
+        int start = align < 0 ? 0 : (align == 0 ? -length / 2 : -length);
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            const uint8_t *g = _glyph(text[i]);
+            for (int col = 0; col < 5; col++)
+                for (int row = 0; row < 7; row++)
+                {
+                    if (!(g[col] >> row & 1))
+                        continue;
+                    int u = start + (static_cast<int>(i) * 6 + col) * scale;
+                    int v = (row - 3) * scale - scale / 2;
+                    if (vertical)
+                        _rect(x + v, y - u - scale, x + v + scale, y - u, color);
+                    else
+                        _rect(x + u, y + v, x + u + scale, y + v + scale, color);
+                }
+        }
+    }
+
+    /**
+     * @brief Draws a point marker centered on (x, y)
+     */
+    inline void _marker(const Series &s, double x, double y, int scale, uint32_t color)
+    {
+        double r = 3.0 * scale * s.point_size / 2.0;
+        switch (s.marker)
+        {
+        case PLUS:
+            _line(x - r, y, x + r, y, 1.0, color);
+            _line(x, y - r, x, y + r, 1.0, color);
+            break;
+        case CROSS:
+            _line(x - r, y - r, x + r, y + r, 1.0, color);
+            _line(x - r, y + r, x + r, y - r, 1.0, color);
+            break;
+        case BOX:
+            _line(x - r, y - r, x + r, y - r, 1.0, color);
+            _line(x + r, y - r, x + r, y + r, 1.0, color);
+            _line(x + r, y + r, x - r, y + r, 1.0, color);
+            _line(x - r, y + r, x - r, y - r, 1.0, color);
+            break;
+        case BOX_F:
+            _rect(static_cast<int>(x - r), static_cast<int>(y - r), static_cast<int>(x + r + 1), static_cast<int>(y + r + 1), color);
+            break;
+        case CIRCLE:
+            _circle(x, y, r, 1.0, false, color);
+            break;
+        case CIRCLE_F:
+            _circle(x, y, r, 1.0, true, color);
+            break;
+        case GLYPH:
+            _text(std::string(1, s.glyph), static_cast<int>(x + 0.5 * scale), static_cast<int>(y), std::max(1, static_cast<int>(scale * s.point_size + 0.5)), 0, color);
+            break;
+        default:
+            break;
+        }
+    }
+
+    /**
+     * @brief Maps a line series to pixels, keeping only the first, lowest, highest and last point of each run of points within one pixel column
+     * @note The drawn polyline is unchanged at pixel resolution, while the number of segments is bounded by four per column for sorted x
+     */
+    template <typename MapX, typename MapY>
+    inline static void _decimate(const Series &s, size_t n, MapX map_x, MapY map_y, std::vector<double> &px, std::vector<double> &py)
+    {
+        size_t first = 0;
+        while (first < n)
+        {
+            const double column = std::floor(map_x(s.x[first]));
+            size_t last = first, lo = first, hi = first;
+            while (last + 1 < n && std::floor(map_x(s.x[last + 1])) == column && std::isfinite(s.y[last + 1]))
+            {
+                last++;
+                if (s.y[last] < s.y[lo])
+                    lo = last;
+                if (s.y[last] > s.y[hi])
+                    hi = last;
+            }
+
+            size_t keep[4] = {first, std::min(lo, hi), std::max(lo, hi), last};
+            for (int k = 0; k < 4; k++)
+                if (k == 0 || keep[k] != keep[k - 1])
+                {
+                    px.push_back(map_x(s.x[keep[k]]));
+                    py.push_back(map_y(s.y[keep[k]]));
+                }
+            first = last + 1;
+        }
+    }
+
+    /**
+     * @brief Returns a round tick step giving roughly `target` ticks over `range`
+     */
+    inline static double _tick_step(double range, int target)
+    {
+        double raw = range / std::max(1, target);
+        double mag = std::pow(10.0, std::floor(std::log10(raw)));
+        double norm = raw / mag;
+        return (norm < 1.5 ? 1.0 : norm < 3.0 ? 2.0
+                               : norm < 7.0   ? 5.0
+                                              : 10.0) *
+               mag;
+    }
+
+    /**
+     * @brief Returns the multiples of `step` within [lo, hi], at most 1000 of them
+     * @note  Gives a single tick at `lo` if `step` is below the spacing of doubles there, e.g. for nanosecond timestamps
+     */
+    inline static std::vector<double> _ticks(double lo, double hi, double step)
+    {
+        std::vector<double> ticks;
+        const double first = std::ceil(lo / step - 1e-9), last = std::floor(hi / step + 1e-9);
+        if (!(last - first < 1000.0) || lo + step == lo || hi + step == hi)
+        {
+            ticks.push_back(lo);
+            return ticks;
+        }
+        // An integer counter, since adding `step` to a large tick may not change it
+        for (long k = 0; k <= static_cast<long>(last - first); k++)
+            ticks.push_back((first + k) * step);
+        return ticks;
+    }
+
+    /**
+     * @brief Formats a tick value, snapping rounding noise to the tick step
+     */
+    inline static std::string _tick_label(double value, double step)
+    {
+        double snapped = std::round(value / step) * step;
+        if (std::fabs(snapped) < step * 1e-9)
+            snapped = 0.0;
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%g", snapped);
+        return buf;
+    }
+
+    /**
+     * @brief Computes the data range of all series on one axis, extended to whole ticks as gnuplot does
+     */
+    inline void _autoscale(bool y_axis, double &lo, double &hi, int target) const
+    {
+        lo = INFINITY;
+        hi = -INFINITY;
+        for (const Series &s : series)
+        {
+            for (double v : (y_axis ? s.y : s.x))
+                if (std::isfinite(v))
+                    lo = std::min(lo, v), hi = std::max(hi, v);
+            if (y_axis)
+                for (double v : s.y2)
+                    if (std::isfinite(v))
+                        lo = std::min(lo, v), hi = std::max(hi, v);
+        }
+        if (!(lo <= hi))
+            lo = -10.0, hi = 10.0;
+        if (lo == hi)
+            lo -= 1.0, hi += 1.0;
+        double step = _tick_step(hi - lo, target);
+        lo = std::floor(lo / step + 1e-9) * step;
+        hi = std::ceil(hi / step - 1e-9) * step;
+    }
+
+public:
+    /**
+     * @brief Returns the default color of the n-th auto colored series, matching gnuplot's default linetypes
+     */
+    inline static uint32_t autoColor(int index)
+    {
+        static const uint32_t colors[8] = {0x9400d3ff, 0x009e73ff, 0x56b4e9ff, 0xe69f00ff, 0xf0e442ff, 0x0072b2ff, 0xe51e10ff, 0x000000ff};
+        return colors[index % 8];
+    }
+
+    /**
+     * @brief Parses a gnuplot color specification into RGBA
+     * @param spec: a color name known to the renderer or "#rrggbb"
+     * @param color: parsed color, with full opacity
+     * @return false if the color is not understood
+     */
+    inline static bool parseColor(const std::string &spec, uint32_t &color)
+    {
+        static const struct
+        {
+            const char *name;
+            uint32_t rgb;
+        } names[] = {
+            {"black", 0x000000}, {"white", 0xffffff}, {"red", 0xff0000}, {"green", 0x00ff00}, {"blue", 0x0000ff}, {"yellow", 0xffff00}, {"cyan", 0x00ffff}, {"magenta", 0xff00ff}, {"orange", 0xffa500}, {"purple", 0xc080ff}, {"brown", 0xa52a2a}, {"pink", 0xffc0c0}, {"grey", 0xc0c0c0}, {"gray", 0xbebebe}, {"dark-grey", 0xa0a0a0}, {"dark-gray", 0xa0a0a0}, {"light-grey", 0xd0d0d0}, {"light-gray", 0xd3d3d3}, {"dark-red", 0x8b0000}, {"dark-green", 0x006400}, {"dark-blue", 0x00008b}, {"light-red", 0xf03232}, {"light-green", 0x90ee90}, {"light-blue", 0xadd8e6}, {"violet", 0xee82ee}, {"gold", 0xffd700}, {"navy", 0x000080}, {"web-green", 0x00c000}, {"web-blue", 0x0080ff},
+        };
+        if (spec.size() == 7 && spec[0] == '#')
+        {
+            char *end = nullptr;
+            unsigned long rgb = strtoul(spec.c_str() + 1, &end, 16);
+            if (*end != '\0')
+                return false;
+            color = static_cast<uint32_t>(rgb) << 8 | 0xff;
+            return true;
+        }
+        for (const auto &n : names)
+            if (spec == n.name)
+            {
+                color = n.rgb << 8 | 0xff;
+                return true;
+            }
+        return false;
+    }
+
+    /**
+     * @brief Resets all figure settings to the defaults and drops the series
+     */
+    inline void reset()
+    {
+        title.clear();
+        xlabel.clear();
+        ylabel.clear();
+        grid = false;
+        legend = true;
+        legend_box = false;
+        legend_left = false;
+        has_xlim = has_ylim = false;
+        series.clear();
+    }
+
+    /**
+     * @brief Renders the current figure into an RGBA buffer
+     * @return the buffer, `width` * `height` * 4 bytes, valid until the next render
+     */
+    inline const std::vector<uint8_t> &render()
+    {
+        rgba.assign(static_cast<size_t>(width) * height * 4, 0xff);
+        clip_x0 = clip_y0 = 0;
+        clip_x1 = width;
+        clip_y1 = height;
+
+        const int scale = std::max(1, (font_size + 4) / 8);
+        const int char_w = 6 * scale, char_h = 8 * scale;
+        const uint32_t black = 0x000000ff;
+
+        // Axes ranges and tick steps
+        int target_x = std::max(2, width / (char_w * 10));
+        int target_y = std::max(2, height / (char_h * 4));
+        double x0 = xmin, x1 = xmax, y0 = ymin, y1 = ymax;
+        if (!has_xlim)
+            _autoscale(false, x0, x1, target_x);
+        if (!has_ylim)
+            _autoscale(true, y0, y1, target_y);
+        if (x0 == x1)
+            x1 = x0 + 1.0;
+        if (y0 == y1)
+            y1 = y0 + 1.0;
+        double xstep = _tick_step(std::fabs(x1 - x0), target_x);
+        double ystep = _tick_step(std::fabs(y1 - y0), target_y);
+
+        const std::vector<double> yticks = _ticks(std::min(y0, y1), std::max(y0, y1), ystep);
+        const std::vector<double> xticks = _ticks(std::min(x0, x1), std::max(x0, x1), xstep);
+
+        size_t ylabel_chars = 1;
+        for (double t : yticks)
+            ylabel_chars = std::max(ylabel_chars, _tick_label(t, ystep).size());
+
+        // Plot area
+        const int left = static_cast<int>(ylabel_chars + 2) * char_w + (ylabel.empty() ? 0 : 2 * char_h);
+        const int right = width - 2 * char_w;
+        const int top = title.empty() ? char_h * 2 : char_h * 4;
+        const int bottom = height - char_h * 3 - (xlabel.empty() ? 0 : 2 * char_h);
+        auto map_x = [&](double v)
+        { return left + (v - x0) / (x1 - x0) * (right - left); };
+        auto map_y = [&](double v)
+        { return bottom - (v - y0) / (y1 - y0) * (bottom - top); };
+
+        // Grid and ticks
+        const int tick = char_w;
+        for (double t : xticks)
+        {
+            double px = map_x(t);
+            if (grid)
+                _line(px, top, px, bottom, 1.0, 0xa0a0a0ff);
+            _line(px, bottom, px, bottom - tick, 1.0, black);
+            _line(px, top, px, top + tick, 1.0, black);
+            _text(_tick_label(t, xstep), static_cast<int>(px), bottom + char_h, scale, 0, black);
+        }
+        for (double t : yticks)
+        {
+            double py = map_y(t);
+            if (grid)
+                _line(left, py, right, py, 1.0, 0xa0a0a0ff);
+            _line(left, py, left + tick, py, 1.0, black);
+            _line(right, py, right - tick, py, 1.0, black);
+            _text(_tick_label(t, ystep), left - char_w, static_cast<int>(py), scale, 1, black);
+        }
+
+        // Labels
+        if (!title.empty())
+            _text(title, (left + right) / 2, char_h * 2, scale, 0, black);
+        if (!xlabel.empty())
+            _text(xlabel, (left + right) / 2, bottom + char_h * 3, scale, 0, black);
+        if (!ylabel.empty())
+            _text(ylabel, char_h, (top + bottom) / 2, scale, 0, black, true);
+
+        // Series, clipped to the plot area
+        clip_x0 = left;
+        clip_y0 = top;
+        clip_x1 = right + 1;
+        clip_y1 = bottom + 1;
+        int n_auto = 0;
+        std::vector<uint32_t> colors(series.size());
+        for (size_t k = 0; k < series.size(); k++)
+        {
+            const Series &s = series[k];
+            uint32_t color = s.auto_color ? autoColor(n_auto++) : s.color;
+            color = (color & 0xffffff00) | static_cast<uint32_t>(std::max(0.0, std::min(1.0, s.alpha)) * 255.0 + 0.5);
+            colors[k] = color;
+            size_t n = std::min(s.x.size(), s.y.size());
+
+            if (s.kind == FILL)
+            {
+                n = std::min(n, s.y2.size());
+                for (size_t i = 0; i + 1 < n; i++)
+                {
+                    double pa = map_x(s.x[i]), pb = map_x(s.x[i + 1]);
+                    if (!(pb > pa))
+                        continue;
+                    for (int px = static_cast<int>(std::ceil(pa - 0.5)); px < static_cast<int>(std::ceil(pb - 0.5)); px++)
+                    {
+                        double t = (px + 0.5 - pa) / (pb - pa);
+                        double ya = map_y(s.y[i] + t * (s.y[i + 1] - s.y[i]));
+                        double yb = map_y(s.y2[i] + t * (s.y2[i + 1] - s.y2[i]));
+                        if (!std::isfinite(ya) || !std::isfinite(yb))
+                            continue;
+                        if (ya > yb)
+                            std::swap(ya, yb);
+                        for (int py = static_cast<int>(std::floor(ya)); py <= static_cast<int>(std::floor(yb)); py++)
+                            _blend(px, py, color, std::min(py + 1.0, yb) - std::max(static_cast<double>(py), ya));
+                    }
+                }
+                continue;
+            }
+
+            if (s.kind == LINE)
+            {
+                std::vector<double> px, py;
+                _decimate(s, n, map_x, map_y, px, py);
+                for (size_t i = 0; i + 1 < px.size(); i++)
+                    _line(px[i], py[i], px[i + 1], py[i + 1], std::max(1.0, s.line_width), color);
+            }
+            if (s.marker != NO_MARKER)
+                for (size_t i = 0; i < n; i++)
+                    if (std::isfinite(s.x[i]) && std::isfinite(s.y[i]))
+                        _marker(s, map_x(s.x[i]), map_y(s.y[i]), scale, color);
+        }
+
+        // Border and legend
+        clip_x0 = clip_y0 = 0;
+        clip_x1 = width;
+        clip_y1 = height;
+        _line(left, top, right, top, 1.0, black);
+        _line(right, top, right, bottom, 1.0, black);
+        _line(right, bottom, left, bottom, 1.0, black);
+        _line(left, bottom, left, top, 1.0, black);
+
+        if (legend)
+        {
+            size_t key_chars = 0;
+            int entries = 0;
+            for (const Series &s : series)
+                if (!s.title.empty())
+                    key_chars = std::max(key_chars, s.title.size()), entries++;
+
+            if (entries > 0)
+            {
+                const int sample = 4 * char_w;
+                const int key_w = static_cast<int>(key_chars) * char_w + sample + 3 * char_w;
+                const int key_x = legend_left ? left + char_w : right - char_w - key_w;
+                int key_y = top + char_h;
+                if (legend_box)
+                {
+                    _line(key_x, top + char_h / 2, key_x + key_w, top + char_h / 2, 1.0, black);
+                    _line(key_x + key_w, top + char_h / 2, key_x + key_w, top + char_h / 2 + entries * char_h * 3 / 2, 1.0, black);
+                    _line(key_x + key_w, top + char_h / 2 + entries * char_h * 3 / 2, key_x, top + char_h / 2 + entries * char_h * 3 / 2, 1.0, black);
+                    _line(key_x, top + char_h / 2 + entries * char_h * 3 / 2, key_x, top + char_h / 2, 1.0, black);
+                }
+                for (size_t k = 0; k < series.size(); k++)
+                {
+                    const Series &s = series[k];
+                    if (s.title.empty())
+                        continue;
+                    int sx = key_x + key_w - char_w - sample;
+                    _text(s.title, sx - char_w, key_y + char_h / 4, scale, 1, black);
+                    if (s.kind == FILL)
+                        _rect(sx, key_y - char_h / 3, sx + sample, key_y + char_h / 3, colors[k]);
+                    else if (s.kind == LINE)
+                        _line(sx, key_y, sx + sample, key_y, std::max(1.0, s.line_width), colors[k]);
+                    if (s.marker != NO_MARKER)
+                        _marker(s, sx + sample / 2.0, key_y, scale, colors[k]);
+                    key_y += char_h * 3 / 2;
+                }
+            }
+        }
+
+        return rgba;
+    }
+
+    /**
+     * @brief Encodes an RGBA buffer as a PNG image
+     * @param pixels: `width` * `height` * 4 bytes, row by row from the top
+     * @param width: width of the image
+     * @param height: height of the image
+     * @param png: output buffer; its capacity is reused across calls
+     * @note The image data is compressed with a fast single-pass deflate (fixed Huffman codes, hashed LZ77 matches)
+     */
+    inline static void encodePNG(const uint8_t *pixels, int width, int height, std::vector<uint8_t> &png)
+    {
+        // Function-local statics are initialized exactly once, even when several threads encode at the same time
+        struct CrcTable
+        {
+            uint32_t entry[256];
+        };
+        static const CrcTable crc_table = []
+        {
+            CrcTable table;
+            for (uint32_t n = 0; n < 256; n++)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++)
+                    c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                table.entry[n] = c;
+            }
+            return table;
+        }();
+
+        auto put32 = [&](uint32_t v)
+        {
+            png.push_back(v >> 24);
+            png.push_back(v >> 16);
+            png.push_back(v >> 8);
+            png.push_back(v);
+        };
+        auto chunk_end = [&](size_t start)
+        {
+            uint32_t length = static_cast<uint32_t>(png.size() - start - 8);
+            png[start] = length >> 24;
+            png[start + 1] = length >> 16;
+            png[start + 2] = length >> 8;
+            png[start + 3] = length;
+            uint32_t c = 0xffffffffu;
+            for (size_t i = start + 4; i < png.size(); i++)
+                c = crc_table.entry[(c ^ png[i]) & 0xff] ^ (c >> 8);
+            put32(c ^ 0xffffffffu);
+        };
+
+        png.clear();
+        static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        png.insert(png.end(), signature, signature + 8);
+
+        size_t start = png.size();
+        put32(0);
+        png.insert(png.end(), {'I', 'H', 'D', 'R'});
+        put32(width);
+        put32(height);
+        png.insert(png.end(), {8, 6, 0, 0, 0});
+        chunk_end(start);
+
+        // Raw scanlines, each prefixed with filter type 0
+        const size_t row_bytes = static_cast<size_t>(width) * 4;
+        std::vector<uint8_t> raw((row_bytes + 1) * height);
+        for (int r = 0; r < height; r++)
+        {
+            raw[r * (row_bytes + 1)] = 0;
+            memcpy(&raw[r * (row_bytes + 1) + 1], pixels + r * row_bytes, row_bytes);
+        }
+
+        start = png.size();
+        put32(0);
+        png.insert(png.end(), {'I', 'D', 'A', 'T'});
+        png.push_back(0x78);
+        png.push_back(0x01);
+
+        uint32_t bit_buffer = 0;
+        int bit_count = 0;
+        auto put_bits = [&](uint32_t bits, int count)
+        {
+            bit_buffer |= bits << bit_count;
+            bit_count += count;
+            while (bit_count >= 8)
+            {
+                png.push_back(bit_buffer & 0xff);
+                bit_buffer >>= 8;
+                bit_count -= 8;
+            }
+        };
+        auto reverse = [](uint32_t code, int length)
+        {
+            uint32_t reversed = 0;
+            for (int i = 0; i < length; i++)
+                reversed |= ((code >> i) & 1) << (length - 1 - i);
+            return reversed;
+        };
+        struct FixedCodes
+        {
+            uint32_t sym_code[288], dist_code[30];
+            int sym_len[288];
+        };
+        static const FixedCodes codes = [reverse]
+        {
+            FixedCodes fixed;
+            for (int sym = 0; sym < 288; sym++)
+            {
+                if (sym < 144)
+                    fixed.sym_code[sym] = reverse(0x30 + sym, fixed.sym_len[sym] = 8);
+                else if (sym < 256)
+                    fixed.sym_code[sym] = reverse(0x190 + sym - 144, fixed.sym_len[sym] = 9);
+                else if (sym < 280)
+                    fixed.sym_code[sym] = reverse(sym - 256, fixed.sym_len[sym] = 7);
+                else
+                    fixed.sym_code[sym] = reverse(0xc0 + sym - 280, fixed.sym_len[sym] = 8);
+            }
+            for (int d = 0; d < 30; d++)
+                fixed.dist_code[d] = reverse(d, 5);
+            return fixed;
+        }();
+        auto put_symbol = [&](int sym)
+        {
+            put_bits(codes.sym_code[sym], codes.sym_len[sym]);
+        };
+
+        static const int len_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const int len_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const int dist_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static const int dist_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        put_bits(1, 1); // final block
+        put_bits(1, 2); // fixed Huffman codes
+        const int hash_bits = 15;
+        std::vector<int64_t> head(1 << hash_bits, -1);
+        const size_t n = raw.size();
+        size_t i = 0;
+        while (i < n)
+        {
+            int best_len = 0;
+            size_t best_dist = 0;
+            if (i + 3 <= n)
+            {
+                uint32_t h = ((raw[i] << 16 | raw[i + 1] << 8 | raw[i + 2]) * 2654435761u) >> (32 - hash_bits);
+                int64_t cand = head[h];
+                head[h] = i;
+                if (cand >= 0 && i - cand <= 32768)
+                {
+                    size_t limit = std::min<size_t>(258, n - i);
+                    int len = 0;
+                    while (len < static_cast<int>(limit) && raw[cand + len] == raw[i + len])
+                        len++;
+                    if (len >= 3)
+                        best_len = len, best_dist = i - cand;
+                }
+            }
+
+            if (best_len == 0)
+            {
+                put_symbol(raw[i]);
+                i++;
+                continue;
+            }
+
+            int lc = 28;
+            while (len_base[lc] > best_len)
+                lc--;
+            put_symbol(257 + lc);
+            put_bits(best_len - len_base[lc], len_extra[lc]);
+            int dc = 29;
+            while (dist_base[dc] > static_cast<int>(best_dist))
+                dc--;
+            put_bits(codes.dist_code[dc], 5);
+            put_bits(static_cast<uint32_t>(best_dist - dist_base[dc]), dist_extra[dc]);
+
+            // Index the skipped positions sparsely so long runs stay cheap
+            for (size_t j = i + 1; j < i + best_len && j + 3 <= n; j += 4)
+                head[((raw[j] << 16 | raw[j + 1] << 8 | raw[j + 2]) * 2654435761u) >> (32 - hash_bits)] = j;
+            i += best_len;
+        }
+        put_symbol(256);
+        if (bit_count > 0)
+            put_bits(0, 8 - bit_count);
+
+        uint32_t a = 1, b = 0;
+        for (size_t k = 0; k < n;)
+        {
+            // 5552 is the largest run that cannot overflow before the modulo
+            size_t end = std::min(n, k + 5552);
+            for (; k < end; k++)
+            {
+                a += raw[k];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        put32(b << 16 | a);
+        chunk_end(start);
+
+        start = png.size();
+        put32(0);
+        png.insert(png.end(), {'I', 'E', 'N', 'D'});
+        chunk_end(start);
+    }
+
+    /**
+     * @brief Renders the current figure and writes it to a PNG file
+     * @param path: path of the PNG file
+     * @return false if the file could not be written
+     */
+    inline bool save(const char *path)
+    {
+        std::vector<uint8_t> png;
+        encodePNG(render().data(), width, height, png);
+        FILE *fout = fopen(path, "wb");
+        if (!fout)
+            return false;
+        bool ok = fwrite(png.data(), 1, png.size(), fout) == png.size();
+        return fclose(fout) == 0 && ok;
+    }
+};
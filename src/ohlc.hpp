@@ -0,0 +1,193 @@
+// ****************************
+// * Author: Abhinav Barnwal
+// * URL: https://github.com/barnawalabhinav/cppplotlib
+// * This code is a part of the project "cppplotlib" which is a simple C++ wrapper for gnuplot.
+// * The project is licensed under MIT License.
+// ****************************
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief Aggregates a stream of (timestamp, value, volume) ticks into fixed time buckets of open, high, low, close and volume
+ * @note 1. Ticks are folded in as they are appended; a tick in the newest bucket only updates that bucket, and a tick past it opens a new one
+ * @note 2. With a whisker percentile, the values of the newest bucket are kept until it is closed, to find its percentiles; closed buckets only keep their bar
+ * @note 3. Buckets without ticks produce no bar; drawn by Plotter::createCandlestickPlot()
+ */
+class OHLC
+{
+public:
+    struct Bar
+    {
+        int64_t start = 0; // bucket start, in nanoseconds since the epoch
+        double open = 0.0;
+        double high = 0.0;
+        double low = 0.0;
+        double close = 0.0;
+        double volume = 0.0;
+        double whisker_low = 0.0;  // lower percentile, or low without whiskers
+        double whisker_high = 0.0; // upper percentile, or high without whiskers
+        size_t count = 0;
+    };
+
+private:
+    int64_t bucket_ns;
+    double percentile;
+    mutable std::vector<Bar> series;
+    mutable std::vector<double> open_values;
+    mutable bool whiskers_stale = false;
+
+    /**
+     * @brief Sets the whiskers of the newest bar from the values of its bucket
+     */
+    inline void _update_whiskers() const
+    {
+        if (!whiskers_stale || series.empty())
+            return;
+        whiskers_stale = false;
+
+        Bar &bar = series.back();
+        const size_t n = open_values.size();
+        const size_t lo = static_cast<size_t>(percentile / 100.0 * (n - 1));
+        const size_t hi = static_cast<size_t>((100.0 - percentile) / 100.0 * (n - 1) + 0.5);
+        std::nth_element(open_values.begin(), open_values.begin() + lo, open_values.end());
+        bar.whisker_low = open_values[lo];
+        std::nth_element(open_values.begin(), open_values.begin() + hi, open_values.end());
+        bar.whisker_high = open_values[hi];
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param bucket: length of a bucket, e.g. std::chrono::seconds(1) or std::chrono::minutes(5)
+     * @param whisker_percentile: if in (0, 50), the whiskers of each bar span this percentile to its complement, e.g. 5 for 5% to 95%; otherwise they span low to high
+     */
+    inline explicit OHLC(const std::chrono::nanoseconds bucket, const double whisker_percentile = 0.0)
+        : bucket_ns(bucket.count()), percentile(whisker_percentile > 0.0 && whisker_percentile < 50.0 ? whisker_percentile : 0.0)
+    {
+        if (bucket_ns <= 0)
+            throw std::runtime_error("ERROR: OHLC bucket length must be positive!");
+    }
+
+    /**
+     * @brief Adds a tick
+     * @param timestamp: time of the tick, in nanoseconds since the epoch
+     * @param value: value of the tick, e.g. a price or a latency
+     * @param volume: volume of the tick
+     * @note A tick older than the newest bucket updates the high, low, volume and count of its bucket, but not its open, close or whiskers
+     * @overload
+     */
+    inline void append(const int64_t timestamp, const double value, const double volume = 0.0)
+    {
+        if (value != value)
+            return;
+
+        int64_t start = timestamp - ((timestamp % bucket_ns) + bucket_ns) % bucket_ns;
+        if (series.empty() || start > series.back().start)
+        {
+            _update_whiskers();
+            open_values.clear();
+
+            Bar bar;
+            bar.start = start;
+            bar.open = bar.high = bar.low = bar.close = value;
+            bar.whisker_low = bar.whisker_high = value;
+            series.push_back(bar);
+        }
+        else if (start < series.back().start)
+        {
+            auto it = std::lower_bound(series.begin(), series.end(), start, [](const Bar &bar, int64_t t)
+                                       { return bar.start < t; });
+            if (it == series.end() || it->start != start)
+            {
+                Bar bar;
+                bar.start = start;
+                bar.open = bar.high = bar.low = bar.close = value;
+                bar.whisker_low = bar.whisker_high = value;
+                it = series.insert(it, bar);
+            }
+            it->high = std::max(it->high, value);
+            it->low = std::min(it->low, value);
+            if (percentile == 0.0)
+            {
+                it->whisker_low = it->low;
+                it->whisker_high = it->high;
+            }
+            it->volume += volume;
+            it->count++;
+            return;
+        }
+
+        Bar &bar = series.back();
+        bar.high = std::max(bar.high, value);
+        bar.low = std::min(bar.low, value);
+        bar.close = value;
+        bar.volume += volume;
+        bar.count++;
+        if (percentile > 0.0)
+        {
+            open_values.push_back(value);
+            whiskers_stale = true;
+        }
+        else
+        {
+            bar.whisker_low = bar.low;
+            bar.whisker_high = bar.high;
+        }
+    }
+
+    /**
+     * @brief Adds a tick
+     * @tparam Clock: clock of the time point
+     * @tparam Duration: duration type of the time point
+     * @param time: time of the tick
+     * @param value: value of the tick, e.g. a price or a latency
+     * @param volume: volume of the tick
+     * @overload
+     */
+    template <typename Clock, typename Duration>
+    inline void append(const std::chrono::time_point<Clock, Duration> &time, const double value, const double volume = 0.0)
+    {
+        append(static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count()), value, volume);
+    }
+
+    /**
+     * @brief Returns the bars in order of time, the last one being the open bucket
+     */
+    inline const std::vector<Bar> &bars() const
+    {
+        _update_whiskers();
+        return series;
+    }
+
+    /**
+     * @brief Returns the length of a bucket in nanoseconds
+     */
+    inline int64_t bucketLength() const
+    {
+        return bucket_ns;
+    }
+
+    /**
+     * @brief Returns true if the whiskers span percentiles rather than low to high
+     */
+    inline bool hasPercentileWhiskers() const
+    {
+        return percentile > 0.0;
+    }
+
+    /**
+     * @brief Removes all bars
+     */
+    inline void clear()
+    {
+        series.clear();
+        open_values.clear();
+        whiskers_stale = false;
+    }
+};
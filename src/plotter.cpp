@@ -0,0 +1,14 @@
+// ****************************
+// * Author: Abhinav Barnwal
+// * URL: https://github.com/barnawalabhinav/cppplotlib
+// * This code is a part of the project "cppplotlib" which is a simple C++ wrapper for gnuplot.
+// * The project is licensed under MIT License.
+// ****************************
+
+// Compiled part of the cppplotlib_compiled library: the non-template members of Plotter and the
+// plotting templates over int, float, double and int64_t. Built with CPPPLOTLIB_COMPILED defined.
+
+#define CPPPLOTLIB_IMPLEMENTATION
+#include "plotter.hpp"
+
+CPPPLOTLIB_TEMPLATES()
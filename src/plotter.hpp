@@ -15,20 +15,150 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
-#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <vector>
 #include <assert.h>
-#include <fstream>
+#include <limits>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "ohlc.hpp"
+#include "series_index.hpp"
+
+// With CPPPLOTLIB_COMPILED defined, the non-template members and the common instantiations of the numeric
+// plotting templates are compiled once into the cppplotlib_compiled library instead of in every translation unit
+#ifdef CPPPLOTLIB_COMPILED
+#define CPPPLOTLIB_INLINE
+#else
+#define CPPPLOTLIB_INLINE inline
+#endif
+
+// Headers only needed by the out-of-line members, so they stay out of translation units using the compiled library
+#if !defined(CPPPLOTLIB_COMPILED) || defined(CPPPLOTLIB_IMPLEMENTATION)
+#include <complex>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <queue>
+#include <thread>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "native_renderer.hpp"
+#endif
+
+class NativeRenderer;
 
 class Plotter
 {
 private:
     bool debug = false;
     FILE *gnuplotPipe;
+    FILE *gnuplotProcess = nullptr;
     int cnt_files = 0;
+    int plot_width = 1200;
+    int plot_height = 900;
+    int font_size = 20;
+
+    /**
+     * @brief Returns the gnuplot binary format specifier of an element type
+     * @note The pointer argument is only used to select the overload
+     */
+    inline static const char *_binary_format(const int8_t *) { return "%int8"; }
+    inline static const char *_binary_format(const uint8_t *) { return "%uint8"; }
+    inline static const char *_binary_format(const int16_t *) { return "%int16"; }
+    inline static const char *_binary_format(const uint16_t *) { return "%uint16"; }
+    inline static const char *_binary_format(const int32_t *) { return "%int32"; }
+    inline static const char *_binary_format(const uint32_t *) { return "%uint32"; }
+    inline static const char *_binary_format(const int64_t *) { return "%int64"; }
+    inline static const char *_binary_format(const uint64_t *) { return "%uint64"; }
+    inline static const char *_binary_format(const float *) { return "%float32"; }
+    inline static const char *_binary_format(const double *) { return "%float64"; }
+
+    /**
+     * @brief Writes a strided 2D array to a file as raw binary, optionally downsampled by block averaging
+     * @tparam T: type of the array elements
+     * @param filename: name of the file
+     * @param data: pointer to the first element of the first row
+     * @param width: number of columns
+     * @param height: number of rows
+     * @param stride: distance between the starts of two consecutive rows, in elements
+     * @param fx: number of columns averaged into one output column
+     * @param fy: number of rows averaged into one output row
+     * @note With fx = fy = 1 the rows are written straight from `data`; otherwise only one output row is buffered at a time and written as float32
+     */
+    template <typename T>
+    inline void _write_binary_array(const std::string filename, const T *data, const int width, const int height, const int stride, const int fx = 1, const int fy = 1)
+    {
+        FILE *fout = fopen(filename.c_str(), "wb");
+        if (!fout)
+            throw std::runtime_error("ERROR: Could not open " + filename + " for writing!");
+
+        if (fx == 1 && fy == 1)
+        {
+            if (stride == width)
+                fwrite(data, sizeof(T), static_cast<size_t>(width) * height, fout);
+            else
+                for (int r = 0; r < height; r++)
+                    fwrite(data + static_cast<size_t>(r) * stride, sizeof(T), width, fout);
+            fclose(fout);
+            return;
+        }
+
+        const int out_width = (width + fx - 1) / fx;
+        std::vector<double> acc(out_width);
+        std::vector<float> row(out_width);
+        for (int r0 = 0; r0 < height; r0 += fy)
+        {
+            const int r1 = std::min(r0 + fy, height);
+            std::fill(acc.begin(), acc.end(), 0.0);
+            for (int r = r0; r < r1; r++)
+            {
+                const T *src = data + static_cast<size_t>(r) * stride;
+                for (int c = 0; c < width; c++)
+                    acc[c / fx] += static_cast<double>(src[c]);
+            }
+            for (int oc = 0; oc < out_width; oc++)
+            {
+                const int cols = std::min(fx, width - oc * fx);
+                row[oc] = static_cast<float>(acc[oc] / (static_cast<double>(cols) * (r1 - r0)));
+            }
+            fwrite(row.data(), sizeof(float), out_width, fout);
+        }
+        fclose(fout);
+    }
+
+    /**
+     * @brief Writes one value of a data file as a std::ostream with the given precision would
+     * @param precision: significant digits of floating point values
+     */
+    template <typename T>
+    inline static void _write_value(FILE *fout, const T &value, const int precision)
+    {
+        if constexpr (std::is_same<T, char>::value || std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value)
+            fputc(value, fout);
+        else if constexpr (std::is_floating_point<T>::value)
+            fprintf(fout, "%.*Lg", precision, static_cast<long double>(value));
+        else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value)
+            fprintf(fout, "%lld", static_cast<long long>(value));
+        else if constexpr (std::is_integral<T>::value)
+            fprintf(fout, "%llu", static_cast<unsigned long long>(value));
+        else
+            fputs(std::string(value).c_str(), fout);
+    }
 
     /**
      * @brief Writes data to a file
@@ -40,10 +170,16 @@ private:
     template <typename T2>
     inline void _write_data(const std::string filename, const std::vector<T2> y)
     {
-        std::ofstream fout(filename);
+        FILE *fout = fopen(filename.c_str(), "w");
+        if (!fout)
+            throw std::runtime_error("ERROR: Could not open " + filename + " for writing!");
         for (int i = 0; i < y.size(); i++)
-            fout << i << " " << y[i] << "\n";
-        fout.close();
+        {
+            fprintf(fout, "%d ", i);
+            _write_value(fout, y[i], 6);
+            fputc('\n', fout);
+        }
+        fclose(fout);
     }
 
     /**
@@ -53,19 +189,25 @@ private:
      * @param filename: name of the file
      * @param x: vector of first value
      * @param y: vector of second value
+     * @param precision: significant digits of floating point values; 17 keeps doubles exact
      * @overload
      */
     template <typename T1, typename T2>
-    inline void _write_data(const std::string filename, const std::vector<T1> x, const std::vector<T2> y, const T1 shift = static_cast<T1>(0))
+    inline void _write_data(const std::string filename, const std::vector<T1> x, const std::vector<T2> y, const T1 shift = static_cast<T1>(0), const int precision = 6)
     {
-        std::ofstream fout(filename);
+        FILE *fout = fopen(filename.c_str(), "w");
+        if (!fout)
+            throw std::runtime_error("ERROR: Could not open " + filename + " for writing!");
         for (int i = 0; i < x.size(); i++)
         {
             if (i >= y.size())
                 break;
-            fout << x[i] + shift << " " << y[i] << "\n";
+            _write_value(fout, x[i] + shift, precision);
+            fputc(' ', fout);
+            _write_value(fout, y[i], precision);
+            fputc('\n', fout);
         }
-        fout.close();
+        fclose(fout);
     }
 
     /**
@@ -77,19 +219,63 @@ private:
      * @param x: vector of first value
      * @param y: vector of second value
      * @param z: vector of third value
+     * @param precision: significant digits of floating point values; 17 keeps doubles exact
      * @overload
      */
     template <typename T1, typename T2, typename T3>
-    inline void _write_data(const std::string filename, const std::vector<T1> x, const std::vector<T2> y, const std::vector<T3> z)
+    inline void _write_data(const std::string filename, const std::vector<T1> x, const std::vector<T2> y, const std::vector<T3> z, const int precision = 6)
     {
-        std::ofstream fout(filename);
+        FILE *fout = fopen(filename.c_str(), "w");
+        if (!fout)
+            throw std::runtime_error("ERROR: Could not open " + filename + " for writing!");
         for (int i = 0; i < x.size(); i++)
         {
             if (i >= y.size() || i >= z.size())
                 break;
-            fout << x[i] << " " << y[i] << " " << z[i] << "\n";
+            _write_value(fout, x[i], precision);
+            fputc(' ', fout);
+            _write_value(fout, y[i], precision);
+            fputc(' ', fout);
+            _write_value(fout, z[i], precision);
+            fputc('\n', fout);
+        }
+        fclose(fout);
+    }
+
+    /**
+     * @brief Writes every `row_stride`-th scan row and `col_stride`-th column of a regular mesh to a file, with a blank line after each scan row
+     * @tparam T1
+     * @tparam T2
+     * @tparam T3
+     * @param filename: name of the file
+     * @param x: vector of first value, stored row after row
+     * @param y: vector of second value, stored row after row
+     * @param z: vector of third value, stored row after row
+     * @param rows: number of scan rows
+     * @param cols: number of points in a scan row
+     * @note The last row and column are always kept, so the decimated mesh spans the same area
+     */
+    template <typename T1, typename T2, typename T3>
+    inline void _write_mesh(const std::string filename, const std::vector<T1> &x, const std::vector<T2> &y, const std::vector<T3> &z, const size_t rows, const size_t cols, const size_t row_stride, const size_t col_stride)
+    {
+        FILE *fout = fopen(filename.c_str(), "w");
+        if (!fout)
+            throw std::runtime_error("ERROR: Could not open " + filename + " for writing!");
+        for (size_t r = 0; r < rows; r = (r + 1 < rows && r + row_stride >= rows) ? rows - 1 : r + row_stride)
+        {
+            for (size_t c = 0; c < cols; c = (c + 1 < cols && c + col_stride >= cols) ? cols - 1 : c + col_stride)
+            {
+                size_t i = r * cols + c;
+                _write_value(fout, x[i], 6);
+                fputc(' ', fout);
+                _write_value(fout, y[i], 6);
+                fputc(' ', fout);
+                _write_value(fout, z[i], 6);
+                fputc('\n', fout);
+            }
+            fputc('\n', fout);
         }
-        fout.close();
+        fclose(fout);
     }
 
     // /**
@@ -114,6 +300,18 @@ private:
     // }
 
 public:
+    /**
+     * @brief Handle to a multi-column dataset written once and shared by any number of plots
+     * @note Columns are numbered from 1, as in gnuplot's `using`; the handle stays valid across reset() and multiplot panels
+     */
+    struct Dataset
+    {
+        std::string filename;
+        int n_rows = 0;
+        int n_columns = 0;
+        std::vector<bool> increasing; // per column, whether its values are strictly increasing
+    };
+
     enum LineStyle
     {
         POINT,             // 0
@@ -200,43 +398,61 @@ public:
         Crs,     // 71
     };
 
+    enum Colormap
+    {
+        GRAY,    // 0
+        VIRIDIS, // 1
+        JET,     // 2
+        HOT,     // 3
+        COOLWARM // 4
+    };
+
+    enum Backend
+    {
+        GNUPLOT, // 0
+        NATIVE,  // 1
+        CAPTURE, // 2
+        DAEMON,  // 3
+    };
+
+    enum Terminal
+    {
+        PNGCAIRO, // 0
+        PNG,      // 1
+        SVG,      // 2
+        PDFCAIRO, // 3
+        DRAFT,    // 4
+    };
+
+    enum RollingStatistic
+    {
+        MEAN_STD,        // 0
+        MEDIAN_QUANTILE, // 1
+    };
+
+    /**
+     * @brief Largest number of vertices createLinePlot3D() draws with gnuplot's hidden line removal
+     */
+    static const size_t hidden3d_max_vertices = 4096;
+
     /**
      *  @brief  Constructor
      *  @param  size_x: width of the plot in pixels
      *  @param  size_y: height of the plot in pixels
      *  @param  fontSize: font size to be used in the plot
      *  @param  debugMode: if true, writes the gnuplot commands to a file instead of executing them
+     *  @param  backendMode: Plotter::GNUPLOT to render everything with gnuplot; Plotter::NATIVE to render simple line, scatter and fillBetween figures in-process;
+     *                      Plotter::CAPTURE to only record the commands and data, to be saved with saveBundle() and rendered later with replayBundle();
+     *                      Plotter::DAEMON to send each plot() to the render daemon (plotterd) listening on daemonSocket()
+     *  @note  1. With Plotter::NATIVE, gnuplot is only started for the first figure the native renderer cannot draw; with Plotter::CAPTURE, it is never started
+     *  @note  2. With Plotter::DAEMON, figures are rendered by a local gnuplot if the daemon cannot be reached, or is lost; the destructor waits for the daemon to finish the output
      */
-    inline Plotter(int size_x = 1200, int size_y = 900, int fontSize = 20, bool debugMode = false)
-    {
-        if (debugMode)
-            gnuplotPipe = fopen("debug_plotter.txt", "w");
-        else
-            gnuplotPipe = popen("gnuplot -persistent", "w");
-
-        debug = debugMode;
-
-        if (gnuplotPipe)
-            fprintf(gnuplotPipe, "set terminal pngcairo enhanced font ',%d' size %d, %d\n", fontSize, size_x, size_y);
-        else
-            std::cerr << "Could not set up pipe with gnuplot" << std::endl;
-    }
+    Plotter(int size_x = 1200, int size_y = 900, int fontSize = 20, bool debugMode = false, Backend backendMode = GNUPLOT);
 
     /**
      *  @brief  Destructor
      */
-    inline virtual ~Plotter()
-    {
-        if (gnuplotPipe)
-        {
-            fflush(gnuplotPipe);
-            pclose(gnuplotPipe);
-
-            if (!debug)
-                for (int i = 0; i < cnt_files; i++)
-                    unlink((std::to_string(i) + ".dat").c_str());
-        }
-    }
+    virtual ~Plotter();
 
     /**
      *  @brief  Resets gnuplot settings to default or specified configuration
@@ -244,23 +460,81 @@ public:
      *  @param  size_y: height of the plot in pixels
      *  @param  fontSize: font size to be used in the plot
      */
-    inline void reset(int size_x = 1200, int size_y = 900, int fontSize = 20)
+    void reset(int size_x = 1200, int size_y = 900, int fontSize = 20);
+
+    /**
+     * @brief  Selects the output terminal, trading rendering quality for speed
+     * @param  terminal: Plotter::PNGCAIRO (anti-aliased PNG, the default), Plotter::PNG (libgd PNG), Plotter::SVG, Plotter::PDFCAIRO
+     *                   or Plotter::DRAFT (libgd PNG without anti-aliasing, enhanced text or transparency; the fastest raster terminal)
+     * @note  1. The terminal is kept across reset(); the size and font size are those of the constructor or the last reset()
+     * @note  2. Plotter::PDFCAIRO sizes are converted from pixels to inches at 72 pixels per inch
+     * @note  3. The native backend only renders PNG terminals; SVG and PDF figures are always rendered by gnuplot
+     */
+    inline void set_terminal(const Terminal terminal = PNGCAIRO)
     {
-        fflush(gnuplotPipe);
-        fprintf(gnuplotPipe, "\nreset\n");
-        fprintf(gnuplotPipe, "set terminal pngcairo enhanced font ',%d' size %d, %d\n", fontSize, size_x, size_y);
+        _native_begin();
+        output_terminal = terminal;
+        if (gnuplotPipe)
+            _write_terminal();
+        _native_end();
     }
 
     /**
      *  @brief  Sends an empty command to gnuplot, used to flush commands
      */
-    inline void plot()
+    void plot();
+
+    /**
+     * @brief  Routes the output of the following figures to memory, to be read with renderToBuffer()
+     * @note  1. With Plotter::GNUPLOT, call it before composing a figure to be rendered with renderToBuffer(), so that the figure is rendered once, straight into memory; set_savePath() routes the output back to a file
+     * @note  2. Only needed with Plotter::GNUPLOT; plot() then renders into an internal buffer that is discarded
+     */
+    void set_bufferOutput();
+
+    /**
+     * @brief  Renders the current figure into memory as PNG bytes; use it in place of plot()
+     * @param  buffer: receives the PNG file; its capacity is reused across calls
+     * @param  timeout_ms: time to wait for gnuplot before giving up with an exception
+     * @note  1. gnuplot writes the image to a FIFO that stays open across figures, and the bytes are read back up to the PNG end chunk, so no file is written
+     * @note  2. With Plotter::GNUPLOT, set_bufferOutput() must have been called before the figure was composed; otherwise the figure is drawn to the previous output, as by plot(), and an exception is thrown
+     * @note  3. With Plotter::NATIVE, figures the native renderer can draw are encoded in memory without gnuplot; the others are routed to memory by gnuplot, and the save path is left untouched for the following figures
+     * @note  4. In a multiplot, it ends the multiplot and returns the whole page; in debug mode, `buffer` is left empty
+     */
+    void renderToBuffer(std::vector<std::byte> &buffer, const int timeout_ms = 30000);
+
+    /**
+     * @brief  Writes everything recorded so far into a single, self-contained bundle file
+     * @param  bundle_path: path of the bundle file
+     * @note  1. Only available with Plotter::CAPTURE; the bundle holds the full command stream and every data file (binary payloads stay binary)
+     * @note  2. Render the bundle later, on any machine with gnuplot, with Plotter::replayBundle()
+     * @note  3. `bundle_path` is not a string, it is a char array; use string.c_str() to convert a string to char array
+     */
+    void saveBundle(const char *bundle_path);
+
+    /**
+     * @brief  Renders a bundle written by saveBundle() with gnuplot
+     * @param  bundle_path: path of the bundle file
+     * @param  debugMode: if true, writes the gnuplot commands to "debug_plotter.txt" instead of executing them
+     * @note  1. Data files are staged in a temporary directory and removed once gnuplot exits; output paths are relative to the current directory
+     * @note  2. `bundle_path` is not a string, it is a char array; use string.c_str() to convert a string to char array
+     */
+    static void replayBundle(const char *bundle_path, bool debugMode = false);
+
+    /**
+     * @brief  Returns the path of the Unix domain socket of the render daemon, used by Plotter::DAEMON and plotterd
+     * @note  1. The CPPPLOTLIB_SOCKET environment variable overrides the default, "$XDG_RUNTIME_DIR/cppplotlib.sock", or "/tmp/cppplotlib-<uid>.sock" if XDG_RUNTIME_DIR is not set
+     * @note  2. Clients only use a daemon run by their own user, wherever the socket is
+     */
+    inline static std::string daemonSocket()
     {
-        if (gnuplotPipe)
-        {
-            fprintf(gnuplotPipe, "\n");
-            fflush(gnuplotPipe);
-        }
+        const char *path = getenv("CPPPLOTLIB_SOCKET");
+        if (path && *path)
+            return path;
+        // The runtime directory is private to the user, unlike /tmp where anyone can bind the name first
+        const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+        if (runtime_dir && *runtime_dir)
+            return std::string(runtime_dir) + "/cppplotlib.sock";
+        return "/tmp/cppplotlib-" + std::to_string(getuid()) + ".sock";
     }
 
     /**
@@ -273,37 +547,27 @@ public:
     inline void set_multiplot(int multi_layout_x = 3, int multi_layout_y = 4, const char *title = "")
     {
         fprintf(gnuplotPipe, "set multiplot layout %d, %d title '%s'\n", multi_layout_x, multi_layout_y, title);
+        in_multiplot = true;
     }
 
     /**
      * @brief  Unsets multiplot layout
      */
-    inline void unset_multiplot()
-    {
-        fprintf(gnuplotPipe, "unset multiplot\n");
-    }
+    void unset_multiplot();
 
     /**
      * @brief Sets x-axis label
      * @param label: label text for the x-axis
      * @note  `label` is not a string, it is a char array; use string.c_str() to convert a string to char array
      */
-    void set_xlabel(const char *label)
-    {
-        if (gnuplotPipe)
-            fprintf(gnuplotPipe, "\nset xlabel '%s'\n", label);
-    }
+    void set_xlabel(const char *label);
 
     /**
      * @brief Sets y-axis label
      * @param label: label text for the y-axis
      * @note  `label` is not a string, it is a char array; use string.c_str() to convert a string to char array
      */
-    void set_ylabel(const char *label)
-    {
-        if (gnuplotPipe)
-            fprintf(gnuplotPipe, "\nset ylabel '%s'\n", label);
-    }
+    void set_ylabel(const char *label);
 
     /**
      * @brief Sets y-axis label
@@ -313,8 +577,10 @@ public:
      */
     void set_zlabel(const char *label)
     {
+        _native_begin();
         if (gnuplotPipe)
             fprintf(gnuplotPipe, "\nset zlabel '%s'\n", label);
+        _native_end();
     }
 
     /**
@@ -322,11 +588,7 @@ public:
      * @param title: title text for the plot
      * @note  `title` is not a string, it is a char array; use string.c_str() to convert a string to char array
      */
-    void set_title(const char *title)
-    {
-        if (gnuplotPipe)
-            fprintf(gnuplotPipe, "\nset title '%s'\n", title);
-    }
+    void set_title(const char *title);
 
     /**
      * @brief Sets output plot path
@@ -335,8 +597,19 @@ public:
      */
     void set_savePath(const char *savePath)
     {
-        if (gnuplotPipe)
-            fprintf(gnuplotPipe, "\nset output '%s'\n", savePath);
+        std::string path = savePath;
+        // The daemon renders in its own working directory
+        char cwd[4096];
+        if (backend == DAEMON && path[0] != '/' && getcwd(cwd, sizeof(cwd)))
+            path = std::string(cwd) + "/" + path;
+
+        // In NATIVE mode, gnuplot only learns the path right before a figure it renders itself; See _native_plot()
+        if (_native_begin())
+            native_output = path;
+        else if (gnuplotPipe)
+            fprintf(gnuplotPipe, "\nset output '%s'\n", path.c_str());
+        buffer_output = false;
+        _native_end();
     }
 
     /**
@@ -344,16 +617,7 @@ public:
      * @param show_grid: if true, shows the grid; otherwise, hides the grid
      * @note  To hide the grid, use show_grid(false)
      */
-    inline void show_grid(bool show_grid = true)
-    {
-        if (gnuplotPipe)
-        {
-            if (show_grid)
-                fprintf(gnuplotPipe, "set grid\n");
-            else
-                fprintf(gnuplotPipe, "unset grid\n");
-        }
-    }
+    void show_grid(bool show_grid = true);
 
     /**
      * @brief Sets the position of the legend
@@ -361,43 +625,27 @@ public:
      * @note  1. To hide the legend, use unset_legend()
      * @note  2. `position` is not a string, it is a char array; use string.c_str() to convert a string to char array
      */
-    inline void set_legend(const char *position = "right")
-    {
-        if (gnuplotPipe)
-            fprintf(gnuplotPipe, "set key box %s\n", position);
-    }
+    void set_legend(const char *position = "right");
 
     /**
      * @brief Hides the legend
      * @note To set the position of the legend, use set_legend()
      */
-    inline void unset_legend()
-    {
-        if (gnuplotPipe)
-            fprintf(gnuplotPipe, "unset key\n");
-    }
+    void unset_legend();
 
     /**
      * @brief Sets x-axis range
      * @param min: minimum value of the x-axis
      * @param max: maximum value of the x-axis
      */
-    inline void set_xlim(double min, double max)
-    {
-        if (gnuplotPipe)
-            fprintf(gnuplotPipe, "set xrange [%f:%f]\n", min, max);
-    }
+    void set_xlim(double min, double max);
 
     /**
      * @brief Sets y-axis range
      * @param min: minimum value of the y-axis
      * @param max: maximum value of the y-axis
      */
-    inline void set_ylim(double min, double max)
-    {
-        if (gnuplotPipe)
-            fprintf(gnuplotPipe, "set yrange [%f:%f]\n", min, max);
-    }
+    void set_ylim(double min, double max);
 
     /**
      * @brief Sets z-axis range
@@ -406,8 +654,10 @@ public:
      */
     inline void set_zlim(double min, double max)
     {
+        _native_begin();
         if (gnuplotPipe)
             fprintf(gnuplotPipe, "set zrange [%f:%f]\n", min, max);
+        _native_end();
     }
 
     /**
@@ -464,22 +714,58 @@ public:
             fprintf(gnuplotPipe, "unset logscale z\n");
     }
 
+    /**
+     * @brief Sets the colormap used by image and palette colored plots
+     * @param colormap: colormap; See Plotter::Colormap for options
+     * @param levels: number of discrete colors in the palette; if 0, the palette is continuous
+     */
+    void set_colormap(const Colormap colormap = VIRIDIS, const int levels = 0);
+
+    /**
+     * @brief Sets the range of values mapped onto the colormap
+     * @param min: value mapped to the lowest color
+     * @param max: value mapped to the highest color
+     */
+    inline void set_cblim(double min, double max)
+    {
+        char range[128];
+        snprintf(range, sizeof(range), "[%f:%f]", min, max);
+        cb_range = range;
+        if (gnuplotPipe)
+            fprintf(gnuplotPipe, "set cbrange %s\n", range);
+    }
+
+    /**
+     * @brief Enables or disables the colorbar
+     * @param show_colorbar: if true, shows the colorbar; otherwise, hides the colorbar
+     */
+    void show_colorbar(bool show_colorbar = true);
+
+    /**
+     * @brief Declares that the x-axis values of the following line plots are strictly increasing
+     * @param presorted: if true, line plots are sent as they are; otherwise, each series is checked and, if needed, sorted and de-duplicated before being sent
+     * @note 1. Line plots are drawn in order of x with points of equal x averaged, as gnuplot's `smooth unique` does; the sorting is done here, in parallel for large series
+     * @note 2. The declaration is kept across reset(); declaring unsorted data as presorted draws the line in the given order
+     */
+    inline void set_presorted(bool presorted = true)
+    {
+        presorted_x = presorted;
+    }
+
     /**
      * @brief Sets x-axis ticks
      * @tparam T2: type of the ticks (string or char array)
      * @param ticks: vector of ticks
-     * @note Use this method only if the plot was created without the x values
+     * @param max_ticks: maximum number of labels to show; if 0, as many as fit the plot width at the current font size
+     * @param stride: show every `stride`-th label; if 0, it is derived from `max_ticks`
+     * @note 1. Use this method only if the plot was created without the x values
+     * @note 2. Labels are thinned to a readable subset, so the command stays small however many categories there are
      * @overload
      */
     template <typename T2>
-    void xticks(const std::vector<T2> &ticks)
+    void xticks(const std::vector<T2> &ticks, const int max_ticks = 0, const int stride = 0)
     {
-        std::string xtics_cmd = "set xtics (";
-        for (int i = 0; i < ticks.size() - 1; i++)
-            xtics_cmd += "\"" + ticks[i] + "\" " + std::to_string(i) + ", ";
-
-        xtics_cmd += "\"" + ticks.back() + "\" " + std::to_string(ticks.size() - 1) + ")\n";
-        fprintf(gnuplotPipe, "%s", xtics_cmd.c_str());
+        _write_tics<int>('x', nullptr, ticks, max_ticks, stride);
     }
 
     /**
@@ -488,38 +774,33 @@ public:
      * @tparam T2: type of the ticks (string or char array)
      * @param x: vector of x-axis values
      * @param ticks: vector of tick labels
-     * @note Use this method only if the plot was created with the x values
+     * @param max_ticks: maximum number of labels to show; if 0, as many as fit the plot width at the current font size
+     * @param stride: show every `stride`-th label; if 0, it is derived from `max_ticks`
+     * @note 1. Use this method only if the plot was created with the x values
+     * @note 2. Labels are thinned to a readable subset, so the command stays small however many categories there are
      * @overload
      */
     template <typename T1, typename T2>
-    void xticks(const std::vector<T1> &x, const std::vector<T2> &ticks)
+    void xticks(const std::vector<T1> &x, const std::vector<T2> &ticks, const int max_ticks = 0, const int stride = 0)
     {
         if (x.size() != ticks.size())
             throw std::runtime_error("ERROR: xticks size doesn't match with x!");
 
-        std::string xtics_cmd = "set xtics (";
-        for (int i = 0; i < x.size() - 1; i++)
-            xtics_cmd += "\"" + ticks[i] + "\" " + std::to_string(x[i]) + ", ";
-
-        xtics_cmd += "\"" + ticks.back() + "\" " + std::to_string(x.back()) + ")\n";
-        fprintf(gnuplotPipe, "%s", xtics_cmd.c_str());
+        _write_tics('x', &x, ticks, max_ticks, stride);
     }
 
     /**
      * @brief Sets y-axis ticks
      * @tparam T2: type of the ticks (string or char array)
      * @param ticks: vector of ticks
+     * @param max_ticks: maximum number of labels to show; if 0, as many as fit the plot height at the current font size
+     * @param stride: show every `stride`-th label; if 0, it is derived from `max_ticks`
      * @overload
      */
     template <typename T2>
-    void yticks(const std::vector<T2> &ticks)
+    void yticks(const std::vector<T2> &ticks, const int max_ticks = 0, const int stride = 0)
     {
-        std::string ytics_cmd = "set ytics (";
-        for (int i = 0; i < ticks.size() - 1; i++)
-            ytics_cmd += "\"" + ticks[i] + "\" " + std::to_string(i) + ", ";
-
-        ytics_cmd += "\"" + ticks.back() + "\" " + std::to_string(ticks.size() - 1) + ")\n";
-        fprintf(gnuplotPipe, "%s", ytics_cmd.c_str());
+        _write_tics<int>('y', nullptr, ticks, max_ticks, stride);
     }
 
     /**
@@ -528,20 +809,17 @@ public:
      * @tparam T2: type of the ticks (string or char array)
      * @param y: vector of y-axis values
      * @param ticks: vector of tick labels
+     * @param max_ticks: maximum number of labels to show; if 0, as many as fit the plot height at the current font size
+     * @param stride: show every `stride`-th label; if 0, it is derived from `max_ticks`
      * @overload
      */
     template <typename T1, typename T2>
-    void yticks(const std::vector<T1> &y, const std::vector<T2> &ticks)
+    void yticks(const std::vector<T1> &y, const std::vector<T2> &ticks, const int max_ticks = 0, const int stride = 0)
     {
         if (y.size() != ticks.size())
             throw std::runtime_error("ERROR: yticks size doesn't match with y!");
 
-        std::string ytics_cmd = "set ytics (";
-        for (int i = 0; i < y.size() - 1; i++)
-            ytics_cmd += "\"" + ticks[i] + "\" " + std::to_string(y[i]) + ", ";
-
-        ytics_cmd += "\"" + ticks.back() + "\" " + std::to_string(y.back()) + ")\n";
-        fprintf(gnuplotPipe, "%s", ytics_cmd.c_str());
+        _write_tics('y', &y, ticks, max_ticks, stride);
     }
 
     /**
@@ -552,31 +830,151 @@ public:
      * @param box_width: width of the box
      * @param color: color of the box plot
      */
-    inline void createBoxPlot(const std::vector<std::string> &x, const std::vector<std::vector<double>> &y, const bool show_xticks = true, const double box_width = 0.5, const char *color = "auto")
+    void createBoxPlot(const std::vector<std::string> &x, const std::vector<std::vector<double>> &y, const bool show_xticks = true, const double box_width = 0.5, const char *color = "auto");
+
+    /**
+     * @brief Creates a Kernel Density Estimate (KDE) Plot with one density curve per group of samples
+     * @tparam T: type of the samples
+     * @param groups: vector of vectors containing the samples of each group
+     * @param titles: titles of the groups; missing titles are left empty
+     * @param bandwidth: standard deviation of the Gaussian kernel; if 0, it is chosen for each group by Silverman's rule
+     * @param grid_size: number of points at which each density is evaluated
+     * @param line_width: Width of the density curves
+     * @note 1. Samples are linearly binned onto the grid and convolved with the kernel by FFT, in O(n + m log m) for n samples and m grid points; groups are processed in parallel
+     * @note 2. Only the density curves are sent, as one block per group of a single file; groups without samples are not drawn
+     * @overload
+     */
+    template <typename T>
+    inline void createKDE(const std::vector<std::vector<T>> &groups, const std::vector<std::string> &titles = {}, const double bandwidth = 0.0, const int grid_size = 512, const double line_width = 1.0)
+    {
+        if (grid_size < 2)
+            throw std::runtime_error("ERROR: KDE grid needs at least two points!");
+
+        std::vector<std::vector<double>> grids(groups.size()), densities(groups.size());
+        _parallel_chunks(groups.size(), [&](size_t first, size_t last)
+                         {
+            for (size_t g = first; g < last; g++)
+                _kde(groups[g], bandwidth, grid_size, grids[g], densities[g]); }, 1);
+
+        // Groups without samples get no block, since gnuplot would not count an empty one as an index
+        int blocks = 0;
+        for (const auto &grid : grids)
+            blocks += !grid.empty();
+        if (blocks == 0)
+            throw std::runtime_error("ERROR: KDE needs at least one sample!");
+
+        std::string filename = std::to_string(cnt_files) + ".dat";
+        FILE *fout = fopen(filename.c_str(), "w");
+        if (!fout)
+            throw std::runtime_error("ERROR: Could not open " + filename + " for writing!");
+        for (size_t g = 0; g < groups.size(); g++)
+        {
+            if (grids[g].empty())
+                continue;
+            for (size_t i = 0; i < grids[g].size(); i++)
+                fprintf(fout, "%.10g %.10g\n", grids[g][i], densities[g][i]);
+            fprintf(fout, "\n\n");
+        }
+        fclose(fout);
+
+        fprintf(gnuplotPipe, "plot ");
+        int block = 0;
+        for (size_t g = 0; g < groups.size(); g++)
+        {
+            if (grids[g].empty())
+                continue;
+            fprintf(gnuplotPipe, "%s\"%s\" index %d using 1:2 with lines linewidth %f title '%s'", block == 0 ? "" : ", ", block == 0 ? filename.c_str() : "", block, line_width, g < titles.size() ? titles[g].c_str() : "");
+            block++;
+        }
+
+        cnt_files++;
+    }
+
+    /**
+     * @brief Creates a Kernel Density Estimate (KDE) Plot of one set of samples
+     * @tparam T: type of the samples
+     * @param samples: vector of samples
+     * @param title: title of the density curve
+     * @param bandwidth: standard deviation of the Gaussian kernel; if 0, it is chosen by Silverman's rule
+     * @param grid_size: number of points at which the density is evaluated
+     * @param line_width: Width of the density curve
+     * @note `title` is not a string, it is a char array; use string.c_str() to convert a string to char array
+     * @overload
+     */
+    template <typename T>
+    inline void createKDE(const std::vector<T> &samples, const char *title = "", const double bandwidth = 0.0, const int grid_size = 512, const double line_width = 1.0)
+    {
+        createKDE(std::vector<std::vector<T>>(1, samples), std::vector<std::string>(1, title), bandwidth, grid_size, line_width);
+    }
+
+    /**
+     * @brief Creates a Violin Plot, drawing the kernel density of each group mirrored around its position
+     * @tparam T: type of the samples
+     * @param x: vector of x labels
+     * @param y: vector of vectors containing the samples of each violin
+     * @param bandwidth: standard deviation of the Gaussian kernel; if 0, it is chosen for each group by Silverman's rule
+     * @param violin_width: width of the widest violin
+     * @param color: color of the violins
+     * @param alpha: opacity of the violins
+     * @note 1. Densities are computed as in createKDE(), with groups in parallel; each violin is sent as one closed polygon
+     * @note 2. All violins share one density scale, so their areas are comparable; groups without samples keep their label but are not drawn
+     * @note 3. `color` is not a string, it is a char array; use string.c_str() to convert a string to char array
+     */
+    template <typename T>
+    inline void createViolinPlot(const std::vector<std::string> &x, const std::vector<std::vector<T>> &y, const double bandwidth = 0.0, const double violin_width = 0.8, const char *color = "auto", const double alpha = 0.5)
     {
-        fprintf(gnuplotPipe, "set style data boxplot\n");
-        fprintf(gnuplotPipe, "set style boxplot outliers pointtype 7\n");
+        const int grid_size = 256;
+        std::vector<std::vector<double>> grids(y.size()), densities(y.size());
+        _parallel_chunks(y.size(), [&](size_t first, size_t last)
+                         {
+            for (size_t g = first; g < last; g++)
+                _kde(y[g], bandwidth, grid_size, grids[g], densities[g]); }, 1);
+
+        double peak = 0.0;
+        for (const auto &density : densities)
+            for (double d : density)
+                peak = std::max(peak, d);
+        const double scale = peak > 0.0 ? violin_width / 2.0 / peak : 0.0;
 
-        if (color != "auto")
-            for (int i = 0; i < y.size(); i++)
-                fprintf(gnuplotPipe, "set linetype %d lc '%s' lw 2\n", i + 1, color);
+        // Groups without samples keep their label but get no block, since gnuplot would not count an empty one as an index
+        int blocks = 0;
+        for (const auto &grid : grids)
+            blocks += !grid.empty();
+        if (blocks == 0)
+            throw std::runtime_error("ERROR: Violin plot needs at least one sample!");
 
         std::string filename = std::to_string(cnt_files) + ".dat";
-        std::ofstream fout(filename);
-        for (int j = 0; j < y[0].size() - 1; j++)
+        FILE *fout = fopen(filename.c_str(), "w");
+        if (!fout)
+            throw std::runtime_error("ERROR: Could not open " + filename + " for writing!");
+        for (size_t g = 0; g < y.size(); g++)
         {
-            for (int i = 0; i < y.size() - 1; i++)
-                fout << y[i][j] << " ";
-            fout << y.back()[j] << "\n";
+            if (grids[g].empty())
+                continue;
+            for (size_t i = 0; i < grids[g].size(); i++)
+                fprintf(fout, "%.10g %.10g\n", g + 1 + densities[g][i] * scale, grids[g][i]);
+            for (size_t i = grids[g].size(); i-- > 0;)
+                fprintf(fout, "%.10g %.10g\n", g + 1 - densities[g][i] * scale, grids[g][i]);
+            fprintf(fout, "%.10g %.10g\n", g + 1 + densities[g][0] * scale, grids[g][0]);
+            fprintf(fout, "\n\n");
         }
-        fout.close();
+        fclose(fout);
 
-        fprintf(gnuplotPipe, "plot '%s' using (1):1 title '' with boxplot,", filename.c_str());
-        for (int i = 1; i < y.size(); i++)
-            fprintf(gnuplotPipe, "'' using (%d):%d title '' with boxplot,", i + 1, i + 1);
+        fprintf(gnuplotPipe, "set xrange [0.5:%f]\n", y.size() + 0.5);
+        fprintf(gnuplotPipe, "set xtics (");
+        for (size_t g = 0; g < y.size(); g++)
+            fprintf(gnuplotPipe, "%s'%s' %d", g == 0 ? "" : ", ", g < x.size() ? x[g].c_str() : "", static_cast<int>(g + 1));
+        fprintf(gnuplotPipe, ")\n");
+
+        fprintf(gnuplotPipe, "plot ");
+        for (int block = 0; block < blocks; block++)
+        {
+            fprintf(gnuplotPipe, "%s\"%s\" index %d using 1:2 with filledcurves closed fill transparent solid %f border", block == 0 ? "" : ", ", block == 0 ? filename.c_str() : "", block, alpha);
+            if (std::string(color) != "auto")
+                fprintf(gnuplotPipe, " linecolor '%s'", color);
+            fprintf(gnuplotPipe, " title ''");
+        }
 
-        fprintf(gnuplotPipe, "\n");
-        fprintf(gnuplotPipe, "unset style boxplot\n");
         cnt_files++;
     }
 
@@ -594,28 +992,7 @@ public:
      * @overload
      */
     template <typename T2>
-    inline void createScatterPlot(const std::vector<T2> &y, const char *point_type = "O", const double point_size = 1.0, const char *title = "", const char *point_color = "auto", const bool set_range = false)
-    {
-        std::string filename = std::to_string(cnt_files) + ".dat";
-        _write_data(filename, y);
-
-        if (set_range)
-        {
-            fprintf(gnuplotPipe, "stats '%s' using 1:2 nooutput\n", filename.c_str());
-            fprintf(gnuplotPipe, "x_offset = (STATS_max_x - STATS_min_x) * 0.05\n");
-            fprintf(gnuplotPipe, "y_offset = (STATS_max_y - STATS_min_y) * 0.05\n");
-            fprintf(gnuplotPipe, "set xrange [STATS_min_x - x_offset:STATS_max_x + x_offset]\n");
-            fprintf(gnuplotPipe, "set yrange [STATS_min_y - y_offset:STATS_max_y + y_offset]\n");
-        }
-
-        fprintf(gnuplotPipe, "plot ");
-        if (point_color == "auto")
-            fprintf(gnuplotPipe, "\"%s\" using 1:2 with points pointtype '%s' pointsize %f title '%s'", filename.c_str(), point_type, point_size, title);
-        else
-            fprintf(gnuplotPipe, "\"%s\" using 1:2 with points pointtype '%s' pointsize %f linecolor '%s' title '%s'", filename.c_str(), point_type, point_size, point_color, title);
-
-        cnt_files++;
-    }
+    void createScatterPlot(const std::vector<T2> &y, const char *point_type = "O", const double point_size = 1.0, const char *title = "", const char *point_color = "auto", const bool set_range = false);
 
     /**
      * @brief Creates a Scatter Plot
@@ -633,28 +1010,7 @@ public:
      * @overload
      */
     template <typename T1, typename T2>
-    inline void createScatterPlot(const std::vector<T1> &x, const std::vector<T2> &y, const char *point_type = "O", const double point_size = 1.0, const char *title = "", const char *point_color = "auto", const bool set_range = false)
-    {
-        std::string filename = std::to_string(cnt_files) + ".dat";
-        _write_data(filename, x, y, static_cast<T1>(0));
-
-        if (set_range)
-        {
-            fprintf(gnuplotPipe, "stats '%s' using 1:2 nooutput\n", filename.c_str());
-            fprintf(gnuplotPipe, "x_offset = (STATS_max_x - STATS_min_x) * 0.05\n");
-            fprintf(gnuplotPipe, "y_offset = (STATS_max_y - STATS_min_y) * 0.05\n");
-            fprintf(gnuplotPipe, "set xrange [STATS_min_x - x_offset:STATS_max_x + x_offset]\n");
-            fprintf(gnuplotPipe, "set yrange [STATS_min_y - y_offset:STATS_max_y + y_offset]\n");
-        }
-
-        fprintf(gnuplotPipe, "plot ");
-        if (point_color == "auto")
-            fprintf(gnuplotPipe, "\"%s\" using 1:2 with points pointtype '%s' pointsize %f title '%s'", filename.c_str(), point_type, point_size, title);
-        else
-            fprintf(gnuplotPipe, "\"%s\" using 1:2 with points pointtype '%s' pointsize %f linecolor '%s' title '%s'", filename.c_str(), point_type, point_size, point_color, title);
-
-        cnt_files++;
-    }
+    void createScatterPlot(const std::vector<T1> &x, const std::vector<T2> &y, const char *point_type = "O", const double point_size = 1.0, const char *title = "", const char *point_color = "auto", const bool set_range = false);
 
     /**
      * @brief Adds a Scatter Plot to existing plot
@@ -668,18 +1024,7 @@ public:
      * @overload
      */
     template <typename T2>
-    inline void addScatterPlot(const std::vector<T2> &y, const char *point_type = "O", const double point_size = 1.0, const char *title = "", const char *point_color = "auto")
-    {
-        std::string filename = std::to_string(cnt_files) + ".dat";
-        _write_data(filename, y);
-
-        if (point_color == "auto")
-            fprintf(gnuplotPipe, ", \"%s\" using 1:2 with points pointtype '%s' pointsize %f title '%s'", filename.c_str(), point_type, point_size, title);
-        else
-            fprintf(gnuplotPipe, ", \"%s\" using 1:2 with points pointtype '%s' pointsize %f linecolor '%s' title '%s'", filename.c_str(), point_type, point_size, point_color, title);
-
-        cnt_files++;
-    }
+    void addScatterPlot(const std::vector<T2> &y, const char *point_type = "O", const double point_size = 1.0, const char *title = "", const char *point_color = "auto");
 
     /**
      * @brief Adds a Scatter Plot to existing plot
@@ -695,37 +1040,138 @@ public:
      * @overload
      */
     template <typename T1, typename T2>
-    inline void addScatterPlot(const std::vector<T1> &x, const std::vector<T2> &y, const char *point_type = "O", const double point_size = 1.0, const char *title = "", const char *point_color = "auto")
-    {
-        std::string filename = std::to_string(cnt_files) + ".dat";
-        _write_data(filename, x, y, static_cast<T1>(0));
-
-        if (point_color == "auto")
-            fprintf(gnuplotPipe, ", \"%s\" using 1:2 with points pointtype '%s' pointsize %f title '%s'", filename.c_str(), point_type, point_size, title);
-        else
-            fprintf(gnuplotPipe, ", \"%s\" using 1:2 with points pointtype '%s' pointsize %f linecolor '%s' title '%s'", filename.c_str(), point_type, point_size, point_color, title);
-
-        cnt_files++;
-    }
+    void addScatterPlot(const std::vector<T1> &x, const std::vector<T2> &y, const char *point_type = "O", const double point_size = 1.0, const char *title = "", const char *point_color = "auto");
 
     /**
-     * @brief Creates a Histogram
+     * @brief Creates a Scatter Plot whose points are colored, and optionally sized, by per-point values
+     * @tparam T1: type of the x-axis values
      * @tparam T2: type of the y-axis values
+     * @tparam T3: type of the color values
+     * @param x: vector of x-axis values
      * @param y: vector of y-axis values
-     * @param bin_width: width of the bin; if 0, the bin width is automatically determined
-     * @param color: color of the histogram bars
+     * @param values: vector of values mapped onto the colormap, one per point
+     * @param sizes: vector of point sizes, one per point, scaled by `point_size`; if empty, every point has size `point_size`
+     * @param point_type: type of the point (e.g., "O", "X", "s", "d", "p", "h", "1", "2", etc.)
+     * @param point_size: size of the point
      * @param title: title of the plot
-     * @param opacity: opacity of the histogram bars
-     * @note `title` and `color` are not strings, they are char arrays; use string.c_str() to convert a string to char array
-     * @overload
+     * @param set_range: if true, automatically sets the axes range of the plot overriding any previous settings
+     * @note 1. All channels are packed into one float64 binary record per point, so a series is a single payload however many colors it has
+     * @note 2. Use set_colormap(), set_cblim() and show_colorbar() to style the color scale
+     * @note 3. `title` and `point_type` are not strings, they are char arrays; use string.c_str() to convert a string to char array
      */
-    template <typename T2>
-    inline void createHistogram(const std::vector<T2> &y, const double bin_width = 0.0, const char *color = "auto", const char *title = "", const double opacity = 1.0)
+    template <typename T1, typename T2, typename T3>
+    inline void createColorScatterPlot(const std::vector<T1> &x, const std::vector<T2> &y, const std::vector<T3> &values, const std::vector<double> &sizes = {}, const char *point_type = "O", const double point_size = 1.0, const char *title = "", const bool set_range = false)
     {
-        fprintf(gnuplotPipe, "set style data histograms\n");
-
         std::string filename = std::to_string(cnt_files) + ".dat";
-        _write_data(filename, y);
+        _write_channels(filename, x, y, values, sizes);
+
+        if (set_range)
+        {
+            fprintf(gnuplotPipe, "stats '%s' binary format='%s' using 1:2 nooutput\n", filename.c_str(), sizes.empty() ? "%float64%float64%float64" : "%float64%float64%float64%float64");
+            fprintf(gnuplotPipe, "x_offset = (STATS_max_x - STATS_min_x) * 0.05\n");
+            fprintf(gnuplotPipe, "y_offset = (STATS_max_y - STATS_min_y) * 0.05\n");
+            fprintf(gnuplotPipe, "set xrange [STATS_min_x - x_offset:STATS_max_x + x_offset]\n");
+            fprintf(gnuplotPipe, "set yrange [STATS_min_y - y_offset:STATS_max_y + y_offset]\n");
+        }
+
+        fprintf(gnuplotPipe, "plot ");
+        _color_series(filename, !sizes.empty(), false, point_type, point_size, title);
+
+        cnt_files++;
+    }
+
+    /**
+     * @brief Adds a Scatter Plot whose points are colored, and optionally sized, by per-point values to existing plot
+     * @tparam T1: type of the x-axis values
+     * @tparam T2: type of the y-axis values
+     * @tparam T3: type of the color values
+     * @param x: vector of x-axis values
+     * @param y: vector of y-axis values
+     * @param values: vector of values mapped onto the colormap, one per point
+     * @param sizes: vector of point sizes, one per point, scaled by `point_size`; if empty, every point has size `point_size`
+     * @param point_type: type of the point (e.g., "O", "X", "s", "d", "p", "h", "1", "2", etc.)
+     * @param point_size: size of the point
+     * @param title: title of the plot
+     * @note `title` and `point_type` are not strings, they are char arrays; use string.c_str() to convert a string to char array
+     */
+    template <typename T1, typename T2, typename T3>
+    inline void addColorScatterPlot(const std::vector<T1> &x, const std::vector<T2> &y, const std::vector<T3> &values, const std::vector<double> &sizes = {}, const char *point_type = "O", const double point_size = 1.0, const char *title = "")
+    {
+        std::string filename = std::to_string(cnt_files) + ".dat";
+        _write_channels(filename, x, y, values, sizes);
+
+        fprintf(gnuplotPipe, ", ");
+        _color_series(filename, !sizes.empty(), false, point_type, point_size, title);
+
+        cnt_files++;
+    }
+
+    /**
+     * @brief Creates a Line Plot whose segments are colored by per-point values
+     * @tparam T1: type of the x-axis values
+     * @tparam T2: type of the y-axis values
+     * @tparam T3: type of the color values
+     * @param x: vector of x-axis values
+     * @param y: vector of y-axis values
+     * @param values: vector of values mapped onto the colormap, one per point; each segment takes the color of its first point
+     * @param line_title: title of the line plot
+     * @param line_width: Width of the plotted line
+     * @note 1. Points are joined in the given order; x, y and the values are sent as one float64 binary record per point
+     * @note 2. Use set_colormap(), set_cblim() and show_colorbar() to style the color scale
+     */
+    template <typename T1, typename T2, typename T3>
+    inline void createColorLinePlot(const std::vector<T1> &x, const std::vector<T2> &y, const std::vector<T3> &values, const char *line_title = "", const double line_width = 1.0)
+    {
+        std::string filename = std::to_string(cnt_files) + ".dat";
+        _write_channels(filename, x, y, values, {});
+
+        fprintf(gnuplotPipe, "plot ");
+        _color_series(filename, false, true, "", line_width, line_title);
+
+        cnt_files++;
+    }
+
+    /**
+     * @brief Adds a Line Plot whose segments are colored by per-point values to existing plot
+     * @tparam T1: type of the x-axis values
+     * @tparam T2: type of the y-axis values
+     * @tparam T3: type of the color values
+     * @param x: vector of x-axis values
+     * @param y: vector of y-axis values
+     * @param values: vector of values mapped onto the colormap, one per point; each segment takes the color of its first point
+     * @param line_title: title of the line plot
+     * @param line_width: Width of the plotted line
+     */
+    template <typename T1, typename T2, typename T3>
+    inline void addColorLinePlot(const std::vector<T1> &x, const std::vector<T2> &y, const std::vector<T3> &values, const char *line_title = "", const double line_width = 1.0)
+    {
+        std::string filename = std::to_string(cnt_files) + ".dat";
+        _write_channels(filename, x, y, values, {});
+
+        fprintf(gnuplotPipe, ", ");
+        _color_series(filename, false, true, "", line_width, line_title);
+
+        cnt_files++;
+    }
+
+    /**
+     * @brief Creates a Histogram
+     * @tparam T2: type of the y-axis values
+     * @param y: vector of y-axis values
+     * @param bin_width: width of the bin; if 0, the bin width is automatically determined
+     * @param color: color of the histogram bars
+     * @param title: title of the plot
+     * @param opacity: opacity of the histogram bars
+     * @note `title` and `color` are not strings, they are char arrays; use string.c_str() to convert a string to char array
+     * @overload
+     */
+    template <typename T2>
+    inline void createHistogram(const std::vector<T2> &y, const double bin_width = 0.0, const char *color = "auto", const char *title = "", const double opacity = 1.0)
+    {
+        fprintf(gnuplotPipe, "set style data histograms\n");
+
+        std::string filename = std::to_string(cnt_files) + ".dat";
+        _write_data(filename, y);
 
         // Determine the range of the data
         fprintf(gnuplotPipe, "stats '%s' using 1:2 nooutput\n", filename.c_str());
@@ -796,27 +1242,7 @@ public:
      * @overload
      */
     template <typename T2>
-    inline void createPlot(const std::vector<T2> &y, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID, const bool set_range = false)
-    {
-        std::string filename = std::to_string(cnt_files) + ".dat";
-        _write_data(filename, y);
-
-        if (set_range)
-        {
-            fprintf(gnuplotPipe, "stats '%s' using 1:2 nooutput\n", filename.c_str());
-            fprintf(gnuplotPipe, "x_offset = (STATS_max_x - STATS_min_x) * 0.05\n");
-            fprintf(gnuplotPipe, "y_offset = (STATS_max_y - STATS_min_y) * 0.05\n");
-            fprintf(gnuplotPipe, "set xrange [STATS_min_x - x_offset:STATS_max_x + x_offset]\n");
-            fprintf(gnuplotPipe, "set yrange [STATS_min_y - y_offset:STATS_max_y + y_offset]\n");
-        }
-        fprintf(gnuplotPipe, "plot ");
-        if (line_color == "auto")
-            fprintf(gnuplotPipe, "\"%s\" using 1:2 smooth unique with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_title);
-        else
-            fprintf(gnuplotPipe, "\"%s\" using 1:2 smooth unique with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_color, line_title);
-
-        cnt_files++;
-    }
+    void createPlot(const std::vector<T2> &y, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID, const bool set_range = false);
 
     /**
      * @brief Creates a Line Plot
@@ -837,28 +1263,7 @@ public:
      * @overload
      */
     template <typename T1, typename T2>
-    inline void createPlot(const std::vector<T1> &x, const std::vector<T2> &y, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID, const T1 shift = static_cast<T1>(0), const bool set_range = false)
-    {
-        std::string filename = std::to_string(cnt_files) + ".dat";
-        _write_data(filename, x, y, shift);
-
-        if (set_range)
-        {
-            fprintf(gnuplotPipe, "stats '%s' using 1:2 nooutput\n", filename.c_str());
-            fprintf(gnuplotPipe, "x_offset = (STATS_max_x - STATS_min_x) * 0.05\n");
-            fprintf(gnuplotPipe, "y_offset = (STATS_max_y - STATS_min_y) * 0.05\n");
-            fprintf(gnuplotPipe, "set xrange [STATS_min_x - x_offset:STATS_max_x + x_offset]\n");
-            fprintf(gnuplotPipe, "set yrange [STATS_min_y - y_offset:STATS_max_y + y_offset]\n");
-        }
-
-        fprintf(gnuplotPipe, "plot ");
-        if (line_color == "auto")
-            fprintf(gnuplotPipe, "\"%s\" using 1:2 smooth unique with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_title);
-        else
-            fprintf(gnuplotPipe, "\"%s\" using 1:2 smooth unique with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_color, line_title);
-
-        cnt_files++;
-    }
+    void createPlot(const std::vector<T1> &x, const std::vector<T2> &y, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID, const T1 shift = static_cast<T1>(0), const bool set_range = false);
 
     /**
      * @brief Creates a Line Plot
@@ -875,18 +1280,7 @@ public:
      * @overload
      */
     template <typename T2>
-    inline void addPlot(const std::vector<T2> &y, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID)
-    {
-        std::string filename = std::to_string(cnt_files) + ".dat";
-        _write_data(filename, y);
-
-        if (line_color == "auto")
-            fprintf(gnuplotPipe, ", \"%s\" using 1:2 smooth unique with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_title);
-        else
-            fprintf(gnuplotPipe, ", \"%s\" using 1:2 smooth unique with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_color, line_title);
-
-        cnt_files++;
-    }
+    void addPlot(const std::vector<T2> &y, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID);
 
     /**
      * @brief Creates a Line Plot
@@ -906,18 +1300,129 @@ public:
      * @overload
      */
     template <typename T1, typename T2>
-    inline void addPlot(const std::vector<T1> &x, const std::vector<T2> &y, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID, const T1 shift = static_cast<T1>(0))
-    {
-        std::string filename = std::to_string(cnt_files) + ".dat";
-        _write_data(filename, x, y, shift);
+    void addPlot(const std::vector<T1> &x, const std::vector<T2> &y, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID, const T1 shift = static_cast<T1>(0));
 
-        if (line_color == "auto")
-            fprintf(gnuplotPipe, ", \"%s\" using 1:2 smooth unique with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_title);
-        else
-            fprintf(gnuplotPipe, ", \"%s\" using 1:2 smooth unique with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_color, line_title);
+    /**
+     * @brief Creates a Line Plot against time
+     * @tparam Clock: clock of the time points
+     * @tparam Duration: duration type of the time points, e.g. std::chrono::nanoseconds
+     * @tparam T2: type of the y-axis values
+     * @param x: vector of time points; those of std::chrono::system_clock are shown as UTC dates and times
+     * @param y: vector of y-axis values
+     * @param line_title: title of the line plot
+     * @param line_color: color of the line plot
+     * @param marker: point marker style; See Plotter::MarkerStyle for options
+     * @param point_size: point marker size; Only relevant if marker is not Plotter::None
+     * @param line_width: Width of the plotted line
+     * @param line_style: line style; See Plotter::LineStyle for options
+     * @param time_format: strftime-like format of the x tick labels, e.g. "%H:%M:%.3S" for milliseconds
+     * @note 1. Timestamps are sent as binary 64-bit integer ticks counted from a whole second, so they are not formatted as text; gnuplot holds times as double seconds since the epoch, which resolves present-day times to about 0.25 microseconds
+     * @note 2. The x-axis stays a time axis until reset()
+     * @overload
+     */
+    template <typename Clock, typename Duration, typename T2>
+    void createPlot(const std::vector<std::chrono::time_point<Clock, Duration>> &x, const std::vector<T2> &y, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID, const char *time_format = "%H:%M:%S");
 
-        cnt_files++;
-    }
+    /**
+     * @brief Creates a Line Plot against elapsed time
+     * @tparam Rep: arithmetic type of the durations
+     * @tparam Period: tick period of the durations, e.g. std::nano
+     * @tparam T2: type of the y-axis values
+     * @param x: vector of durations
+     * @param y: vector of y-axis values
+     * @param line_title: title of the line plot
+     * @param line_color: color of the line plot
+     * @param marker: point marker style; See Plotter::MarkerStyle for options
+     * @param point_size: point marker size; Only relevant if marker is not Plotter::None
+     * @param line_width: Width of the plotted line
+     * @param line_style: line style; See Plotter::LineStyle for options
+     * @param time_format: relative time format of the x tick labels, e.g. "%tM:%.3tS"
+     * @note Durations are sent as binary 64-bit integer ticks counted from a whole second, so they are not formatted as text and convert exactly over spans of up to 2^53 ticks (104 days of nanoseconds)
+     * @overload
+     */
+    template <typename Rep, typename Period, typename T2>
+    void createPlot(const std::vector<std::chrono::duration<Rep, Period>> &x, const std::vector<T2> &y, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID, const char *time_format = "%tH:%tM:%tS");
+
+    /**
+     * @brief Adds a Line Plot against time to an existing time plot
+     * @tparam Clock: clock of the time points
+     * @tparam Duration: duration type of the time points, e.g. std::chrono::nanoseconds
+     * @tparam T2: type of the y-axis values
+     * @param x: vector of time points
+     * @param y: vector of y-axis values
+     * @param line_title: title of the line plot
+     * @param line_color: color of the line plot
+     * @param marker: point marker style; See Plotter::MarkerStyle for options
+     * @param point_size: point marker size; Only relevant if marker is not Plotter::None
+     * @param line_width: Width of the plotted line
+     * @param line_style: line style; See Plotter::LineStyle for options
+     * @overload
+     */
+    template <typename Clock, typename Duration, typename T2>
+    void addPlot(const std::vector<std::chrono::time_point<Clock, Duration>> &x, const std::vector<T2> &y, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID);
+
+    /**
+     * @brief Adds a Line Plot against elapsed time to an existing plot
+     * @tparam Rep: arithmetic type of the durations
+     * @tparam Period: tick period of the durations, e.g. std::nano
+     * @tparam T2: type of the y-axis values
+     * @param x: vector of durations
+     * @param y: vector of y-axis values
+     * @param line_title: title of the line plot
+     * @param line_color: color of the line plot
+     * @param marker: point marker style; See Plotter::MarkerStyle for options
+     * @param point_size: point marker size; Only relevant if marker is not Plotter::None
+     * @param line_width: Width of the plotted line
+     * @param line_style: line style; See Plotter::LineStyle for options
+     * @overload
+     */
+    template <typename Rep, typename Period, typename T2>
+    void addPlot(const std::vector<std::chrono::duration<Rep, Period>> &x, const std::vector<T2> &y, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID);
+
+    /**
+     * @brief Creates a Candlestick or OHLC bar Plot of aggregated ticks, optionally with volume bars
+     * @param ohlc: bars aggregated from ticks; See OHLC
+     * @param financebars: if true, draws open-high-low-close bars; otherwise, draws candlesticks whose whiskers span the bar's whisker range
+     * @param show_volume: if true and any tick has a volume, draws the volume of each bar as boxes on the y2 axis, in the bottom quarter of the plot
+     * @param time_format: strftime-like format of the x tick labels
+     * @param up_color: color of the bars that close at or above their open
+     * @param down_color: color of the bars that close below their open
+     * @note 1. Bar start times are sent as binary 64-bit integer nanoseconds counted from a whole second, with the bar values, as in the time-axis createPlot(); each bar is drawn at the middle of its bucket
+     * @note 2. `time_format`, `up_color` and `down_color` are not strings, they are char arrays; use string.c_str() to convert a string to char array
+     */
+    void createCandlestickPlot(const OHLC &ohlc, const bool financebars = false, const bool show_volume = true, const char *time_format = "%H:%M:%S", const char *up_color = "#2ca02c", const char *down_color = "#d62728");
+
+    /**
+     * @brief Creates a Line Plot of an x-window of an indexed series, sending only the points needed at the width of the plot
+     * @param index: min/max pyramid of the series; See SeriesIndex
+     * @param x_min: lower end of the window, also set as the lower limit of the x-axis
+     * @param x_max: upper end of the window, also set as the upper limit of the x-axis
+     * @param line_title: title of the line plot
+     * @param line_color: color of the line plot
+     * @param marker: point marker style; See Plotter::MarkerStyle for options
+     * @param point_size: point marker size; Only relevant if marker is not Plotter::None
+     * @param line_width: Width of the plotted line
+     * @param line_style: line style; See Plotter::LineStyle for options
+     * @note 1. Windows holding at least `fanout` points per pixel column (see SeriesIndex) are drawn from the minimum and maximum of each bucket, which keeps every peak visible
+     * @note 2. The width of the whole plot is used, so a subplot of a multiplot gets more points than it needs
+     * @overload
+     */
+    void createPlot(const SeriesIndex &index, const double x_min, const double x_max, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID);
+
+    /**
+     * @brief Adds a Line Plot of an x-window of an indexed series to the current plot, sending only the points needed at the width of the plot
+     * @param index: min/max pyramid of the series; See SeriesIndex
+     * @param x_min: lower end of the window
+     * @param x_max: upper end of the window
+     * @param line_title: title of the line plot
+     * @param line_color: color of the line plot
+     * @param marker: point marker style; See Plotter::MarkerStyle for options
+     * @param point_size: point marker size; Only relevant if marker is not Plotter::None
+     * @param line_width: Width of the plotted line
+     * @param line_style: line style; See Plotter::LineStyle for options
+     * @overload
+     */
+    void addPlot(const SeriesIndex &index, const double x_min, const double x_max, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID);
 
     /**
      * @brief Shades the region within specified bounds on y-axis
@@ -930,21 +1435,7 @@ public:
      * @overload
      */
     template <typename T2>
-    inline void fillBetween(const std::vector<T2> &ub, const std::vector<T2> &lb, const char *color = "auto", const double alpha = 0.2)
-    {
-        std::string filename = std::to_string(cnt_files) + ".dat";
-        std::vector<int> x(ub.size());
-        for (int i = 0; i < ub.size(); i++)
-            x[i] = i;
-        _write_data(filename, x, ub, lb);
-
-        if (color == "auto")
-            fprintf(gnuplotPipe, ", \"%s\" using 1:2:3 with filledcurves fill transparent solid %f title ''", filename.c_str(), alpha);
-        else
-            fprintf(gnuplotPipe, ", \"%s\" using 1:2:3 with filledcurves linecolor '%s' fill transparent solid %f title ''", filename.c_str(), color, alpha);
-
-        cnt_files++;
-    }
+    void fillBetween(const std::vector<T2> &ub, const std::vector<T2> &lb, const char *color = "auto", const double alpha = 0.2);
 
     /**
      * @brief Shades the region within specified bounds on y-axis
@@ -958,59 +1449,380 @@ public:
      * @overload
      */
     template <typename T1, typename T2>
-    inline void fillBetween(const std::vector<T1> &x, const std::vector<T2> &ub, const std::vector<T2> &lb, const char *color = "auto", const double alpha = 0.2)
+    void fillBetween(const std::vector<T1> &x, const std::vector<T2> &ub, const std::vector<T2> &lb, const char *color = "auto", const double alpha = 0.2);
+
+    /**
+     * @brief Adds a rolling statistic of a series to an existing plot, as a shaded band and a center line
+     * @tparam T1: type of the x-axis values
+     * @tparam T2: type of the y-axis values
+     * @param x: vector of x-axis values
+     * @param y: vector of y-axis values
+     * @param window: number of samples in the trailing window; the first samples use the ones available
+     * @param statistic: Plotter::MEAN_STD for the mean and a band of `spread` standard deviations around it;
+     *                   Plotter::MEDIAN_QUANTILE for the median and a band holding the central `spread` fraction of the window, e.g. 0.8 for the 10% to 90% quantiles
+     * @param spread: width of the band; See `statistic`
+     * @param line_title: title of the center line
+     * @param color: color of the center line and the band
+     * @param alpha: opacity of the band
+     * @param line_width: Width of the center line
+     * @note 1. `line_title` and `color` are not strings, they are char arrays; use string.c_str() to convert a string to char array
+     * @note 2. The statistics are updated per sample in one pass, in O(1) for Plotter::MEAN_STD and O(log n) for Plotter::MEDIAN_QUANTILE, on parallel chunks for large series;
+     *          NaN samples (and, for Plotter::MEAN_STD, infinite ones) are left out of the windows, and a window without any other sample gives NaN
+     * @note 3. Series longer than twice the plot width are sent decimated: each group of samples becomes one point holding the widest band of the group
+     * @overload
+     */
+    template <typename T1, typename T2>
+    inline void addRollingBand(const std::vector<T1> &x, const std::vector<T2> &y, const int window, const RollingStatistic statistic = MEAN_STD, const double spread = 1.0, const char *line_title = "", const char *color = "auto", const double alpha = 0.2, const double line_width = 1.0)
     {
-        std::string filename = std::to_string(cnt_files) + ".dat";
-        _write_data(filename, x, ub, lb);
+        if (window < 1)
+            throw std::runtime_error("ERROR: Rolling window must hold at least one sample!");
+        if (statistic == MEDIAN_QUANTILE && (spread < 0.0 || spread > 1.0))
+            throw std::runtime_error("ERROR: Quantile band spread must be between 0 and 1!");
 
-        if (color == "auto")
-            fprintf(gnuplotPipe, ", \"%s\" using 1:2:3 with filledcurves fill transparent solid %f title ''", filename.c_str(), alpha);
+        const size_t n = std::min(x.size(), y.size());
+        std::vector<double> values(n), center(n), lb(n), ub(n);
+        for (size_t i = 0; i < n; i++)
+            values[i] = _as_double(y[i]);
+        if (statistic == MEAN_STD)
+            _rolling_mean_std(values, window, spread, center, lb, ub);
         else
-            fprintf(gnuplotPipe, ", \"%s\" using 1:2:3 with filledcurves linecolor '%s' fill transparent solid %f title ''", filename.c_str(), color, alpha);
+            _rolling_quantiles(values, window, (1.0 - spread) / 2.0, (1.0 + spread) / 2.0, center, lb, ub);
 
-        cnt_files++;
+        const size_t group = std::max<size_t>(1, (n + 2 * plot_width - 1) / (2 * plot_width));
+        std::vector<double> gx, gcenter, glb, gub;
+        for (size_t start = 0; start < n; start += group)
+        {
+            const size_t end = std::min(n, start + group);
+            double sum = 0.0;
+            gx.push_back(_as_double(x[(start + end - 1) / 2]));
+            glb.push_back(lb[start]);
+            gub.push_back(ub[start]);
+            for (size_t i = start; i < end; i++)
+            {
+                sum += center[i];
+                glb.back() = std::min(glb.back(), lb[i]);
+                gub.back() = std::max(gub.back(), ub[i]);
+            }
+            gcenter.push_back(sum / (end - start));
+        }
+
+        fillBetween(gx, gub, glb, color, alpha);
+        addPlot(gx, gcenter, line_title, color, None, 1.0, line_width);
     }
 
     /**
-     * @brief Plots A 3D Surface
-     * @tparam T1: type of the x-axis values
+     * @brief Adds a rolling statistic of a series to an existing plot, as a shaded band and a center line
      * @tparam T2: type of the y-axis values
-     * @tparam T3: type of the z-axis values
-     * @param x: vector of x-axis values
-     * @param y: vector of y-axis values
-     * @param z: vector of z-axis values
-     * @param line_title: title of the line plot
-     * @param line_color: color of the line plot
-     * @param marker: point marker style; See Plotter::MarkerStyle for options
-     * @param point_size: point marker size; Only relevant if marker is not Plotter::None
-     * @param line_width: Width of the plotted line
-     * @param line_style: line style; See Plotter::LineStyle for options
-     * @param set_hidden3D: if true, automatically hides the lines which are below the plot and hence invisible
-     * @note 1. `line_title` and `line_color` are not strings, they are char arrays; use string.c_str() to convert a string to char array
-     * @note 2. turn `set_range` to false when plotting multiple lines in the plot using add_plot and rather set the limits manually.
+     * @param y: vector of y-axis values, plotted against their indices
+     * @param window: number of samples in the trailing window; the first samples use the ones available
+     * @param statistic: Plotter::MEAN_STD or Plotter::MEDIAN_QUANTILE; See the overload taking x-axis values
+     * @param spread: width of the band; See the overload taking x-axis values
+     * @param line_title: title of the center line
+     * @param color: color of the center line and the band
+     * @param alpha: opacity of the band
+     * @param line_width: Width of the center line
      * @overload
      */
-    template <typename T1, typename T2, typename T3>
-    inline void createLinePlot3D(const std::vector<T1> &x, const std::vector<T2> &y, const std::vector<T3> &z, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID, const bool set_hidden3D = true)
+    template <typename T2>
+    inline void addRollingBand(const std::vector<T2> &y, const int window, const RollingStatistic statistic = MEAN_STD, const double spread = 1.0, const char *line_title = "", const char *color = "auto", const double alpha = 0.2, const double line_width = 1.0)
     {
-        std::string filename = std::to_string(cnt_files) + ".dat";
-        _write_data(filename, x, y, z);
+        addRollingBand(_indices(y.size()), y, window, statistic, spread, line_title, color, alpha, line_width);
+    }
 
-        if (set_hidden3D)
-            fprintf(gnuplotPipe, "set hidden3d\n");
-        else
-            fprintf(gnuplotPipe, "unset hidden3d\n");
+    /**
+     * @brief Writes a multi-column dataset once, to be plotted column-wise by plotDataset() and addDatasetPlot()
+     * @tparam T: type of the column values
+     * @param columns: vector of columns; column `i` is referenced as `i + 1` when plotting
+     * @return handle to the dataset
+     * @note 1. The columns are written as a single interleaved float64 binary payload; rows beyond the shortest column are dropped
+     * @note 2. Share one dataset between series and multiplot panels so that common columns (e.g. x) are sent only once
+     */
+    template <typename T>
+    inline Dataset createDataset(const std::vector<std::vector<T>> &columns)
+    {
+        if (columns.empty())
+            throw std::runtime_error("ERROR: createDataset needs at least one column!");
 
-        fprintf(gnuplotPipe, "splot ");
-        if (line_color == "auto")
-            fprintf(gnuplotPipe, "\"%s\" using 1:2:3 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_title);
-        else
-            fprintf(gnuplotPipe, "\"%s\" using 1:2:3 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_color, line_title);
+        Dataset data;
+        data.filename = std::to_string(cnt_files) + ".dat";
+        data.n_columns = columns.size();
+        data.n_rows = columns[0].size();
+        for (const auto &column : columns)
+            data.n_rows = std::min<int>(data.n_rows, column.size());
+        if (data.n_rows == 0)
+            throw std::runtime_error("ERROR: createDataset needs at least one row!");
+
+        FILE *fout = fopen(data.filename.c_str(), "wb");
+        if (!fout)
+            throw std::runtime_error("ERROR: Could not open " + data.filename + " for writing!");
+
+        std::vector<double> row(data.n_columns);
+        data.increasing.assign(data.n_columns, true);
+        for (int i = 0; i < data.n_rows; i++)
+        {
+            for (int j = 0; j < data.n_columns; j++)
+            {
+                const double value = static_cast<double>(columns[j][i]);
+                if (!(i == 0 ? value == value : row[j] < value))
+                    data.increasing[j] = false;
+                row[j] = value;
+            }
+            fwrite(row.data(), sizeof(double), data.n_columns, fout);
+        }
+        fclose(fout);
 
         cnt_files++;
+        return data;
     }
 
-    // /**
+    /**
+     * @brief Creates a Line Plot from two columns of a dataset
+     * @param data: dataset handle returned by createDataset()
+     * @param x_column: column holding the x-axis values, counted from 1
+     * @param y_column: column holding the y-axis values, counted from 1
+     * @param line_title: title of the line plot
+     * @param line_color: color of the line plot
+     * @param marker: point marker style; See Plotter::MarkerStyle for options
+     * @param point_size: point marker size; Only relevant if marker is not Plotter::None
+     * @param line_width: Width of the plotted line
+     * @param line_style: line style; See Plotter::LineStyle for options
+     * @param set_range: if true, automatically sets the axes range of the plot overriding any previous settings
+     * @note 1. As with createPlot(), the line is drawn in order of x; if `x_column` is not strictly increasing, the two columns are sorted and de-duplicated into a copy, unless set_presorted() was called
+     * @note 2. `line_title` and `line_color` are not strings, they are char arrays; use string.c_str() to convert a string to char array
+     */
+    void plotDataset(const Dataset &data, const int x_column, const int y_column, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID, const bool set_range = false);
+
+    /**
+     * @brief Adds a Line Plot from two columns of a dataset to existing plot
+     * @param data: dataset handle returned by createDataset()
+     * @param x_column: column holding the x-axis values, counted from 1
+     * @param y_column: column holding the y-axis values, counted from 1
+     * @param line_title: title of the line plot
+     * @param line_color: color of the line plot
+     * @param marker: point marker style; See Plotter::MarkerStyle for options
+     * @param point_size: point marker size; Only relevant if marker is not Plotter::None
+     * @param line_width: Width of the plotted line
+     * @param line_style: line style; See Plotter::LineStyle for options
+     * @note 1. Columns that are not strictly increasing are sorted as in plotDataset()
+     * @note 2. `line_title` and `line_color` are not strings, they are char arrays; use string.c_str() to convert a string to char array
+     */
+    inline void addDatasetPlot(const Dataset &data, const int x_column, const int y_column, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID)
+    {
+        _check_dataset(data, x_column, y_column);
+        const std::string source = _dataset_using(data, x_column, y_column);
+        fprintf(gnuplotPipe, ", ");
+        _dataset_series(source, line_title, line_color, marker, point_size, line_width, line_style);
+    }
+
+    /**
+     * @brief Plots a 2D array as an image (heatmap)
+     * @tparam T: type of the array elements (uint8_t, uint16_t, float, double or any other fixed-width integer)
+     * @param data: pointer to the first element of the first row; rows are drawn top to bottom
+     * @param width: number of columns in the array
+     * @param height: number of rows in the array
+     * @param stride: distance between the starts of two consecutive rows, in elements; if 0, it is taken as `width`
+     * @param title: title of the plot
+     * @param downsample: if true, arrays larger than the output size are block averaged down to it before being sent
+     * @note 1. The array is sent to gnuplot as raw binary, directly from `data` unless downsampled; it is never formatted as text
+     * @note 2. Axes are in array coordinates regardless of downsampling; use set_colormap(), set_cblim() and show_colorbar() to style the color scale
+     */
+    template <typename T>
+    inline void imshow(const T *data, const int width, const int height, const int stride = 0, const char *title = "", const bool downsample = true)
+    {
+        if (width <= 0 || height <= 0)
+            throw std::runtime_error("ERROR: imshow needs a non-empty array!");
+        if (stride != 0 && stride < width)
+            throw std::runtime_error("ERROR: imshow stride is smaller than the width!");
+
+        int fx = 1, fy = 1;
+        if (downsample)
+        {
+            fx = std::max(1, (width + plot_width - 1) / plot_width);
+            fy = std::max(1, (height + plot_height - 1) / plot_height);
+        }
+
+        std::string filename = std::to_string(cnt_files) + ".dat";
+        _write_binary_array(filename, data, width, height, stride == 0 ? width : stride, fx, fy);
+
+        const char *format = (fx == 1 && fy == 1) ? _binary_format(data) : "%float32";
+        fprintf(gnuplotPipe, "plot \"%s\" binary array=(%d,%d) dx=%d dy=%d origin=(%f,%f) format='%s' flipy with image title '%s'", filename.c_str(), (width + fx - 1) / fx, (height + fy - 1) / fy, fx, fy, (fx - 1) / 2.0, (fy - 1) / 2.0, format, title);
+
+        cnt_files++;
+    }
+
+    /**
+     * @brief Plots the contour lines of a 2D array at given levels
+     * @tparam T: type of the array elements
+     * @param data: pointer to the first element of the first row; rows are drawn top to bottom, as in imshow()
+     * @param width: number of columns in the array
+     * @param height: number of rows in the array
+     * @param levels: values at which the contour lines are drawn
+     * @param stride: distance between the starts of two consecutive rows, in elements; if 0, it is taken as `width`
+     * @param title: title of the contour lines
+     * @param line_width: Width of the contour lines
+     * @note 1. The lines are extracted here with marching squares, on parallel bands of rows, and stitched into polylines; only the polylines are sent, colored by level with the current colormap
+     * @note 2. Saddle cells are resolved by the mean of their corners; cells with a NaN corner are skipped
+     * @overload
+     */
+    template <typename T>
+    inline void contour(const T *data, const int width, const int height, const std::vector<double> &levels, const int stride = 0, const char *title = "", const double line_width = 1.0)
+    {
+        std::string filename = std::to_string(cnt_files) + ".dat";
+        _write_contours(filename, data, width, height, stride == 0 ? width : stride, levels);
+
+        fprintf(gnuplotPipe, "plot \"%s\" using 1:2:3 with lines linewidth %f linecolor palette title '%s'", filename.c_str(), line_width, title);
+
+        cnt_files++;
+    }
+
+    /**
+     * @brief Plots the contour lines of a 2D array at evenly spaced levels, optionally over filled bands
+     * @tparam T: type of the array elements
+     * @param data: pointer to the first element of the first row; rows are drawn top to bottom, as in imshow()
+     * @param width: number of columns in the array
+     * @param height: number of rows in the array
+     * @param n_levels: number of levels, evenly spaced strictly between the smallest and the largest value
+     * @param stride: distance between the starts of two consecutive rows, in elements; if 0, it is taken as `width`
+     * @param filled: if true, the bands between levels are filled with one color of the current colormap each, and the lines are drawn in black
+     * @param title: title of the contour lines
+     * @param line_width: Width of the contour lines
+     * @note The filled bands are drawn with imshow() on a colormap limited to `n_levels + 1` colors over the range of the array; see set_colormap(). The colormap and its range set before are restored after the plot
+     * @overload
+     */
+    template <typename T>
+    inline void contour(const T *data, const int width, const int height, const int n_levels = 10, const int stride = 0, const bool filled = false, const char *title = "", const double line_width = 1.0)
+    {
+        if (width <= 0 || height <= 0)
+            throw std::runtime_error("ERROR: contour needs a non-empty array!");
+        if (n_levels < 1)
+            throw std::runtime_error("ERROR: contour needs at least one level!");
+
+        const int row_stride = stride == 0 ? width : stride;
+        double min = INFINITY, max = -INFINITY;
+        for (int r = 0; r < height; r++)
+            for (int c = 0; c < width; c++)
+            {
+                double value = static_cast<double>(data[static_cast<size_t>(r) * row_stride + c]);
+                min = std::min(min, value);
+                max = std::max(max, value);
+            }
+
+        std::vector<double> levels(n_levels);
+        for (int k = 0; k < n_levels; k++)
+            levels[k] = min + (k + 1) * (max - min) / (n_levels + 1);
+
+        if (!filled)
+        {
+            contour(data, width, height, levels, stride, title, line_width);
+            return;
+        }
+
+        fprintf(gnuplotPipe, "set cbrange [%.17g:%.17g]\n", min, max);
+        fprintf(gnuplotPipe, "set palette maxcolors %d\n", n_levels + 1);
+        plot_cleanup += "set cbrange " + cb_range + "\nset palette maxcolors " + std::to_string(palette_levels) + "\n";
+        imshow(data, width, height, stride);
+
+        std::string filename = std::to_string(cnt_files) + ".dat";
+        _write_contours(filename, data, width, height, row_stride, levels);
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2 with lines linewidth %f linecolor 'black' title '%s'", filename.c_str(), line_width, title);
+
+        cnt_files++;
+    }
+
+    /**
+     * @brief Plots A 3D Surface
+     * @tparam T1: type of the x-axis values
+     * @tparam T2: type of the y-axis values
+     * @tparam T3: type of the z-axis values
+     * @param x: vector of x-axis values
+     * @param y: vector of y-axis values
+     * @param z: vector of z-axis values
+     * @param line_title: title of the line plot
+     * @param line_color: color of the line plot
+     * @param marker: point marker style; See Plotter::MarkerStyle for options
+     * @param point_size: point marker size; Only relevant if marker is not Plotter::None
+     * @param line_width: Width of the plotted line
+     * @param line_style: line style; See Plotter::LineStyle for options
+     * @param set_hidden3D: if true, automatically hides the lines which are below the plot and hence invisible
+     * @param max_vertices: number of vertices the data is simplified to; if 0, it is derived from the plot size; if negative, every vertex is sent
+     * @note 1. `line_title` and `line_color` are not strings, they are char arrays; use string.c_str() to convert a string to char array
+     * @note 2. turn `set_range` to false when plotting multiple lines in the plot using add_plot and rather set the limits manually.
+     * @note 3. Points stored row after row on a regular grid (constant y along a row and the same x in every row, or the other way round) are drawn as a mesh and decimated by keeping every n-th row and column;
+     *          any other data is drawn as a polyline and simplified by keeping the vertices that deviate most from the simplified line (Douglas-Peucker)
+     * @note 4. If more than Plotter::hidden3d_max_vertices vertices remain, hidden line removal is too slow: meshes are then drawn as depth sorted pm3d surfaces and polylines without hidden3d
+     * @overload
+     */
+    template <typename T1, typename T2, typename T3>
+    inline void createLinePlot3D(const std::vector<T1> &x, const std::vector<T2> &y, const std::vector<T3> &z, const char *line_title = "", const char *line_color = "auto", const MarkerStyle marker = None, const double point_size = 1.0, const double line_width = 1.0, const LineStyle line_style = SOLID, const bool set_hidden3D = true, const int max_vertices = 0)
+    {
+        std::string filename = std::to_string(cnt_files) + ".dat";
+        const size_t n = std::min(x.size(), std::min(y.size(), z.size()));
+        const size_t budget = max_vertices > 0 ? max_vertices : (max_vertices == 0 ? std::max(64, plot_width * plot_height / 100) : n);
+
+        size_t cols = _mesh_columns(x, y, n);
+        size_t vertices = n;
+        if (cols > 0)
+        {
+            const size_t rows = n / cols;
+            size_t row_stride = 1, col_stride = 1;
+            auto kept = [](size_t count, size_t stride)
+            { return (count + stride - 2) / stride + 1; };
+            while (kept(rows, row_stride) * kept(cols, col_stride) > std::max<size_t>(budget, 4))
+            {
+                if (kept(rows, row_stride) >= kept(cols, col_stride))
+                    row_stride++;
+                else
+                    col_stride++;
+            }
+            vertices = kept(rows, row_stride) * kept(cols, col_stride);
+            _write_mesh(filename, x, y, z, rows, cols, row_stride, col_stride);
+        }
+        else if (n > budget)
+        {
+            std::vector<double> xs(n), ys(n), zs(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                xs[i] = _as_double(x[i]);
+                ys[i] = _as_double(y[i]);
+                zs[i] = _as_double(z[i]);
+            }
+            std::vector<size_t> keep = _simplify_polyline(xs, ys, zs, budget);
+            vertices = keep.size();
+            std::vector<double> kx(vertices), ky(vertices), kz(vertices);
+            for (size_t i = 0; i < vertices; i++)
+            {
+                kx[i] = xs[keep[i]];
+                ky[i] = ys[keep[i]];
+                kz[i] = zs[keep[i]];
+            }
+            _write_data(filename, kx, ky, kz);
+        }
+        else
+            _write_data(filename, x, y, z);
+
+        const bool use_pm3d = set_hidden3D && cols > 0 && vertices > hidden3d_max_vertices;
+        if (set_hidden3D && vertices <= hidden3d_max_vertices)
+            fprintf(gnuplotPipe, "set hidden3d\n");
+        else
+            fprintf(gnuplotPipe, "unset hidden3d\n");
+        if (use_pm3d)
+        {
+            fprintf(gnuplotPipe, "set pm3d depthorder\n");
+            plot_cleanup += "set pm3d scansautomatic\n";
+        }
+
+        fprintf(gnuplotPipe, "splot ");
+        if (use_pm3d)
+            fprintf(gnuplotPipe, "\"%s\" using 1:2:3 with pm3d title '%s'", filename.c_str(), line_title);
+        else if (std::string(line_color) == "auto")
+            fprintf(gnuplotPipe, "\"%s\" using 1:2:3 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_title);
+        else
+            fprintf(gnuplotPipe, "\"%s\" using 1:2:3 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_color, line_title);
+
+        cnt_files++;
+    }
+
+    // /**
     //  * @brief Creates a Scatter Plot
     //  * @tparam T1: type of the x-axis values
     //  * @tparam T2: type of the y-axis values
@@ -1049,4 +1861,2552 @@ public:
 
     //     cnt_files++;
     // }
-};
+
+private:
+    friend class RenderDaemon;
+
+    static constexpr const char *bundle_magic = "CPPPLOTB";
+    static constexpr const char *daemon_magic = "CPPPLOTJ";
+    static const uint64_t daemon_job = 1;   // a bundle of the commands and data files written since the previous job, passed as a file descriptor
+    static const uint64_t daemon_close = 2; // the client is done; its output is closed and its worker released
+    static const int daemon_greeting_ms = 5000; // time a daemon has to greet a new client with the longest it may take to reply
+
+    Backend backend = GNUPLOT;
+    Terminal output_terminal = PNGCAIRO;
+    NativeRenderer *native; // behind a pointer, so native_renderer.hpp is only needed by the out-of-line members
+    std::string native_output;
+    std::string gnuplot_output; // the output gnuplot was last told to use in NATIVE mode; empty for stdout
+    long native_pos = 0;
+    long sent_pos = 0;
+    long figure_pos = -1;
+    bool figure_set_range = false;
+    bool native_ok = true;
+    bool presorted_x = false;
+    std::string buffer_fifo;
+    int buffer_fd = -1;
+    bool buffer_output = false;
+    bool in_multiplot = false;
+    std::string plot_cleanup; // commands undoing settings only the current plot needs; See _cleanup_plot()
+    std::string cb_range = "[*:*]";
+    int palette_levels = 0;
+    std::vector<std::byte> scratch_png;
+    int daemon_fd = -1;
+    bool daemon_failed = false;
+    int daemon_files = 0;
+
+    /**
+     * @brief Returns the data source clause of a dataset for a plot command
+     * @param data: dataset handle returned by createDataset()
+     */
+    inline std::string _dataset_source(const Dataset &data) const
+    {
+        std::string format;
+        for (int j = 0; j < data.n_columns; j++)
+            format += "%float64";
+        return "\"" + data.filename + "\" binary record=(" + std::to_string(data.n_rows) + ") format='" + format + "'";
+    }
+
+    /**
+     * @brief Throws if a dataset has no rows or a column is out of range; called before anything of the plot is written
+     */
+    inline static void _check_dataset(const Dataset &data, const int x_column, const int y_column)
+    {
+        if (data.n_rows <= 0)
+            throw std::runtime_error("ERROR: dataset has no rows!");
+        if (x_column < 1 || x_column > data.n_columns || y_column < 1 || y_column > data.n_columns)
+            throw std::runtime_error("ERROR: dataset column out of range!");
+    }
+
+    /**
+     * @brief Returns the data source and `using` clause of a line series drawn from two dataset columns
+     * @note Writes a sorted and de-duplicated copy of the two columns if `x_column` is not strictly increasing, as _sorted_xy() does for vectors
+     */
+    std::string _dataset_using(const Dataset &data, const int x_column, const int y_column);
+
+    /**
+     * @brief Writes the plot clause of a line series drawn from two dataset columns
+     * @param source: data source and `using` clause returned by _dataset_using()
+     */
+    void _dataset_series(const std::string &source, const char *line_title, const char *line_color, const int marker, const double point_size, const double line_width, const int line_style);
+
+    /**
+     * @brief Returns true if every value is smaller than the next one; NaN values make it false
+     */
+    template <typename K>
+    inline static bool _strictly_increasing(const std::vector<K> &x)
+    {
+        for (size_t i = 1; i < x.size(); i++)
+            if (!(x[i - 1] < x[i]))
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief Sorts points by x and replaces points of equal x by their mean y, as gnuplot's `smooth unique` does
+     * @note Points with a NaN x are dropped; large inputs are sorted in parallel chunks that are then merged pairwise
+     */
+    template <typename K>
+    inline static void _sort_unique(std::vector<K> &x, std::vector<double> &y)
+    {
+        std::vector<std::pair<K, double>> points;
+        points.reserve(x.size());
+        for (size_t i = 0; i < x.size() && i < y.size(); i++)
+            if (x[i] == x[i])
+                points.emplace_back(x[i], y[i]);
+
+        auto by_x = [](const std::pair<K, double> &a, const std::pair<K, double> &b)
+        { return a.first < b.first; };
+        const size_t n_chunks = _chunk_count(points.size(), 1 << 16);
+        if (n_chunks <= 1)
+            std::sort(points.begin(), points.end(), by_x);
+        else
+        {
+            std::vector<size_t> bounds(n_chunks + 1);
+            for (size_t k = 0; k <= n_chunks; k++)
+                bounds[k] = points.size() * k / n_chunks;
+
+            // One thread per chunk, as n_chunks does not exceed the number of threads
+            _parallel_chunks(n_chunks, [&](size_t first, size_t last)
+                             {
+                for (size_t k = first; k < last; k++)
+                    std::sort(points.begin() + bounds[k], points.begin() + bounds[k + 1], by_x); }, 1);
+
+            for (size_t width = 1; width < n_chunks; width *= 2)
+                _parallel_chunks((n_chunks - width + 2 * width - 1) / (2 * width), [&](size_t first, size_t last)
+                                 {
+                    for (size_t k = first * 2 * width; k < last * 2 * width; k += 2 * width)
+                        std::inplace_merge(points.begin() + bounds[k], points.begin() + bounds[k + width], points.begin() + bounds[std::min(k + 2 * width, n_chunks)], by_x); }, 1);
+        }
+
+        x.clear();
+        y.clear();
+        for (size_t i = 0; i < points.size();)
+        {
+            size_t j = i;
+            double sum = 0.0;
+            for (; j < points.size() && points[j].first == points[i].first; j++)
+                sum += points[j].second;
+            x.push_back(points[i].first);
+            y.push_back(sum / (j - i));
+            i = j;
+        }
+    }
+
+    /**
+     * @brief Checks if the x-axis values of a line series are strictly increasing, sorting and de-duplicating them otherwise
+     * @param xs: filled with the sorted x-axis values, including `shift`, if the series is not sorted
+     * @param ys: filled with the matching y-axis values if the series is not sorted
+     * @return true if the series can be sent as it is
+     */
+    template <typename T1, typename T2>
+    inline bool _sorted_xy(const std::vector<T1> &x, const std::vector<T2> &y, const double shift, std::vector<double> &xs, std::vector<double> &ys)
+    {
+        if (presorted_x)
+            return true;
+
+        const size_t n = std::min(x.size(), y.size());
+        double prev = 0.0;
+        bool sorted = true;
+        for (size_t i = 0; i < n && sorted; i++)
+        {
+            double value = _as_double(x[i]);
+            sorted = (i == 0 && value == value) || prev < value;
+            prev = value;
+        }
+        if (sorted)
+            return true;
+
+        xs.resize(n);
+        ys.resize(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            xs[i] = _as_double(x[i]) + shift;
+            ys[i] = _as_double(y[i]);
+        }
+        _sort_unique(xs, ys);
+        return false;
+    }
+
+    /**
+     * @brief Returns the number of points per scan row if the points lie on a regular grid stored row after row, or 0 otherwise
+     * @note A grid needs at least two rows of two points, with either constant y along each row and the same x values in every row, or constant x along each row and the same y values in every row
+     */
+    template <typename T1, typename T2>
+    inline static size_t _mesh_columns(const std::vector<T1> &x, const std::vector<T2> &y, const size_t n)
+    {
+        size_t cols = _scan_columns(x, y, n);
+        return cols > 0 ? cols : _scan_columns(y, x, n);
+    }
+
+    /**
+     * @brief Returns the number of points per scan row if `across` is constant along each scan row and `along` takes the same values in every row, or 0 otherwise
+     */
+    template <typename T1, typename T2>
+    inline static size_t _scan_columns(const std::vector<T1> &along, const std::vector<T2> &across, const size_t n)
+    {
+        size_t cols = 0;
+        while (cols < n && _as_double(across[cols]) == _as_double(across[0]))
+            cols++;
+        if (cols < 2 || cols >= n || n % cols != 0)
+            return 0;
+
+        for (size_t i = cols; i < n; i++)
+        {
+            if (_as_double(along[i]) != _as_double(along[i % cols]) || _as_double(across[i]) != _as_double(across[i - i % cols]))
+                return 0;
+        }
+        return cols;
+    }
+
+    /**
+     * @brief Ranks the vertices of a 3D polyline by Douglas-Peucker importance and returns the indices of the `budget` most important ones, in order
+     * @note Axes are scaled by their ranges, so the deviation is measured in plot proportions; vertices are added while the largest remaining deviation is non-zero
+     */
+    static std::vector<size_t> _simplify_polyline(const std::vector<double> &x, const std::vector<double> &y, const std::vector<double> &z, const size_t budget);
+
+    /**
+     * @brief Calls `task(first, last)` on consecutive chunks of [0, n), on separate threads when the range is large
+     */
+    template <typename Task>
+    inline static void _parallel_chunks(const size_t n, Task task, const size_t min_chunk = 1 << 15)
+    {
+        _run_chunks(n, _chunk_count(n, min_chunk), [](void *context, size_t first, size_t last)
+                    { (*static_cast<Task *>(context))(first, last); }, &task);
+    }
+
+    /**
+     * @brief Returns the number of chunks _parallel_chunks() splits [0, n) into: one per thread, but none smaller than `min_chunk`
+     */
+    static size_t _chunk_count(const size_t n, const size_t min_chunk);
+
+    /**
+     * @brief Calls `run(context, first, last)` on `n_chunks` consecutive chunks of [0, n), each on its own thread if there are several
+     * @note Kept out of line with a plain function pointer, so <thread> is only needed where it is defined
+     */
+    static void _run_chunks(const size_t n, const size_t n_chunks, void (*run)(void *, size_t, size_t), void *context);
+
+    /**
+     * @brief Computes the trailing-window mean and the mean -/+ `spread` standard deviations of every sample
+     * @note Sliding sums are taken relative to the first finite value of each chunk to limit cancellation; values that are not finite are skipped
+     */
+    static void _rolling_mean_std(const std::vector<double> &y, const size_t window, const double spread, std::vector<double> &center, std::vector<double> &lb, std::vector<double> &ub);
+
+    /**
+     * @brief Computes the trailing-window median and the `lower` and `upper` quantiles of every sample
+     * @note Each chunk ranks its own values and the window before it, and keeps the window in a Fenwick tree over those ranks, so a sample is added, removed or a quantile is found in O(log(chunk + window)); NaN values are skipped; quantiles interpolate linearly between order statistics
+     */
+    static void _rolling_quantiles(const std::vector<double> &y, const size_t window, const double lower, const double upper, std::vector<double> &center, std::vector<double> &lb, std::vector<double> &ub);
+
+    /**
+     * @brief Extracts the contour lines of a 2D array with marching squares and writes them as polylines of "x y level" rows separated by blank lines
+     * @note Segments are found on parallel bands of rows and only store the grid edges they join; the segments of each level are then stitched, in parallel over levels, by matching shared edges
+     */
+    template <typename T>
+    inline static void _write_contours(const std::string &filename, const T *data, const int width, const int height, const int stride, std::vector<double> levels)
+    {
+        if (width <= 0 || height <= 0)
+            throw std::runtime_error("ERROR: contour needs a non-empty array!");
+        if (stride < width)
+            throw std::runtime_error("ERROR: contour stride is smaller than the width!");
+        std::sort(levels.begin(), levels.end());
+
+        auto value = [&](uint64_t r, uint64_t c)
+        { return static_cast<double>(data[r * stride + c]); };
+        // Edge ids: 2 * (r * width + c) is the edge from (r, c) to (r, c + 1); one more is the edge from (r, c) to (r + 1, c)
+        auto horizontal = [&](uint64_t r, uint64_t c)
+        { return 2 * (r * width + c); };
+        auto vertical = [&](uint64_t r, uint64_t c)
+        { return 2 * (r * width + c) + 1; };
+
+        const size_t n_levels = levels.size();
+        const size_t n_cells = height > 1 ? height - 1 : 0;
+        // Segments of the band starting at row `first`, per level; only the first row of each band has any
+        std::vector<std::vector<std::vector<uint64_t>>> band_segments(n_cells);
+        _parallel_chunks(n_cells, [&](size_t first, size_t last)
+                         {
+            std::vector<std::vector<uint64_t>> segments(n_levels);
+            for (size_t r = first; r < last; r++)
+                for (int c = 0; c + 1 < width; c++)
+                {
+                    const double v[4] = {value(r, c), value(r, c + 1), value(r + 1, c + 1), value(r + 1, c)};
+                    const double lo = std::min(std::min(v[0], v[1]), std::min(v[2], v[3]));
+                    const double hi = std::max(std::max(v[0], v[1]), std::max(v[2], v[3]));
+                    if (!(lo == lo) || !(hi == hi) || v[0] != v[0] || v[1] != v[1] || v[2] != v[2] || v[3] != v[3])
+                        continue;
+
+                    const uint64_t top = horizontal(r, c), right = vertical(r, c + 1), bottom = horizontal(r + 1, c), left = vertical(r, c);
+                    for (size_t k = std::lower_bound(levels.begin(), levels.end(), lo) - levels.begin(); k < n_levels && levels[k] < hi; k++)
+                    {
+                        const double level = levels[k];
+                        const int index = (v[0] > level) | (v[1] > level) << 1 | (v[2] > level) << 2 | (v[3] > level) << 3;
+                        const bool center = (v[0] + v[1] + v[2] + v[3]) / 4 > level;
+                        std::vector<uint64_t> &out = segments[k];
+                        switch (index)
+                        {
+                        case 1:
+                        case 14:
+                            out.insert(out.end(), {left, top});
+                            break;
+                        case 2:
+                        case 13:
+                            out.insert(out.end(), {top, right});
+                            break;
+                        case 3:
+                        case 12:
+                            out.insert(out.end(), {left, right});
+                            break;
+                        case 4:
+                        case 11:
+                            out.insert(out.end(), {right, bottom});
+                            break;
+                        case 6:
+                        case 9:
+                            out.insert(out.end(), {top, bottom});
+                            break;
+                        case 7:
+                        case 8:
+                            out.insert(out.end(), {bottom, left});
+                            break;
+                        case 5:
+                        case 10:
+                            if ((index == 5) == center)
+                                out.insert(out.end(), {top, right, bottom, left});
+                            else
+                                out.insert(out.end(), {left, top, right, bottom});
+                            break;
+                        }
+                    }
+                }
+            band_segments[first] = std::move(segments); }, 64);
+
+        std::vector<std::vector<uint64_t>> polylines(n_levels);
+        _parallel_chunks(n_levels, [&](size_t first, size_t last)
+                         {
+            for (size_t k = first; k < last; k++)
+            {
+                std::vector<uint64_t> segments;
+                for (auto &band : band_segments)
+                    if (!band.empty())
+                        segments.insert(segments.end(), band[k].begin(), band[k].end());
+
+                // Pair up the two segment ends that share an edge; boundary edges stay unmatched
+                std::vector<std::pair<uint64_t, uint32_t>> ends(segments.size());
+                for (size_t i = 0; i < segments.size(); i++)
+                    ends[i] = std::make_pair(segments[i], static_cast<uint32_t>(i));
+                std::sort(ends.begin(), ends.end());
+                std::vector<int64_t> other(segments.size(), -1);
+                for (size_t i = 0; i + 1 < ends.size(); i++)
+                    if (ends[i].first == ends[i + 1].first)
+                    {
+                        other[ends[i].second] = ends[i + 1].second;
+                        other[ends[i + 1].second] = ends[i].second;
+                        i++;
+                    }
+
+                // Walk open chains from their unmatched ends first, then the closed loops; a 0 id separates polylines
+                std::vector<bool> visited(segments.size() / 2, false);
+                for (int pass = 0; pass < 2; pass++)
+                    for (size_t start = 0; start < segments.size(); start++)
+                    {
+                        if (visited[start / 2] || (pass == 0 && other[start] >= 0))
+                            continue;
+                        polylines[k].push_back(segments[start] + 1);
+                        int64_t end = start;
+                        while (end >= 0 && !visited[end / 2])
+                        {
+                            visited[end / 2] = true;
+                            int64_t exit = end ^ 1;
+                            polylines[k].push_back(segments[exit] + 1);
+                            end = other[exit];
+                        }
+                        polylines[k].push_back(0);
+                    }
+            } }, 1);
+
+        FILE *fout = fopen(filename.c_str(), "w");
+        if (!fout)
+            throw std::runtime_error("ERROR: Could not open " + filename + " for writing!");
+        for (size_t k = 0; k < n_levels; k++)
+            for (uint64_t id : polylines[k])
+            {
+                if (id == 0)
+                {
+                    fprintf(fout, "\n");
+                    continue;
+                }
+                const uint64_t edge = (id - 1) / 2, r = edge / width, c = edge % width;
+                const bool is_vertical = (id - 1) % 2;
+                const double v0 = value(r, c), v1 = is_vertical ? value(r + 1, c) : value(r, c + 1);
+                const double t = v1 != v0 ? (levels[k] - v0) / (v1 - v0) : 0.5;
+                fprintf(fout, "%.7g %.7g %.7g\n", is_vertical ? c : c + t, height - 1 - (is_vertical ? r + t : r), levels[k]);
+            }
+        fclose(fout);
+    }
+
+    /**
+     * @brief In-place radix-2 FFT of `n` complex values stored as interleaved real and imaginary parts; `n` must be a power of two
+     * @param inverse: if true, computes the unscaled inverse transform
+     */
+    static void _fft(double *a, const size_t n, const bool inverse);
+
+    /**
+     * @brief Evaluates the Gaussian kernel density of samples on `m` evenly spaced points spanning the samples and three bandwidths either side
+     * @param bandwidth: kernel standard deviation; if 0, Silverman's rule 0.9 min(sd, IQR / 1.34) n^(-1/5) is used
+     * @note Samples are linearly binned onto the grid, and the bin weights are convolved with the sampled kernel by zero-padded FFT; NaN samples are ignored
+     */
+    template <typename T>
+    inline static void _kde(const std::vector<T> &samples, double bandwidth, const size_t m, std::vector<double> &grid, std::vector<double> &density)
+    {
+        std::vector<double> values;
+        values.reserve(samples.size());
+        for (const T &sample : samples)
+        {
+            double value = _as_double(sample);
+            if (value == value)
+                values.push_back(value);
+        }
+        _kde_values(values, bandwidth, m, grid, density);
+    }
+
+    /**
+     * @brief Evaluates the kernel density of samples that are not NaN; See _kde()
+     */
+    static void _kde_values(const std::vector<double> &values, double bandwidth, const size_t m, std::vector<double> &grid, std::vector<double> &density);
+
+    /**
+     * @brief Writes x, y, a color value and optionally a size per point as float64 binary records
+     * @note Points beyond the shortest channel are dropped
+     */
+    template <typename T1, typename T2, typename T3>
+    inline void _write_channels(const std::string &filename, const std::vector<T1> &x, const std::vector<T2> &y, const std::vector<T3> &values, const std::vector<double> &sizes)
+    {
+        FILE *fout = fopen(filename.c_str(), "wb");
+        if (!fout)
+            throw std::runtime_error("ERROR: Could not open " + filename + " for writing!");
+
+        const size_t channels = sizes.empty() ? 3 : 4;
+        size_t n = std::min(x.size(), std::min(y.size(), values.size()));
+        if (!sizes.empty())
+            n = std::min(n, sizes.size());
+        const size_t chunk = 4096;
+        std::vector<double> buffer(std::min(n, chunk) * channels);
+        for (size_t start = 0; start < n; start += chunk)
+        {
+            const size_t end = std::min(n, start + chunk);
+            double *record = buffer.data();
+            for (size_t i = start; i < end; i++)
+            {
+                *record++ = _as_double(x[i]);
+                *record++ = _as_double(y[i]);
+                *record++ = _as_double(values[i]);
+                if (!sizes.empty())
+                    *record++ = sizes[i];
+            }
+            fwrite(buffer.data(), sizeof(double), (end - start) * channels, fout);
+        }
+        fclose(fout);
+    }
+
+    /**
+     * @brief Writes the plot clause of a series stored by _write_channels(), colored by the palette
+     * @param variable_size: if true, the fourth channel scales the point size
+     * @param line: if true, draws lines of width `size`; otherwise, draws points of type `point_type` and size `size`
+     */
+    void _color_series(const std::string &filename, const bool variable_size, const bool line, const char *point_type, const double size, const char *title);
+
+    /**
+     * @brief Returns the integer tick count of a time point or duration
+     * @overload
+     */
+    template <typename Clock, typename Duration>
+    inline static int64_t _ticks(const std::chrono::time_point<Clock, Duration> &t)
+    {
+        return static_cast<int64_t>(t.time_since_epoch().count());
+    }
+
+    /**
+     * @brief Returns the integer tick count of a time point or duration
+     * @overload
+     */
+    template <typename Rep, typename Period>
+    inline static int64_t _ticks(const std::chrono::duration<Rep, Period> &d)
+    {
+        return static_cast<int64_t>(d.count());
+    }
+
+    /**
+     * @brief Writes (int64 ticks, float64 value) binary records to a file
+     * @tparam T1: time point or duration type
+     * @tparam T2: type of the values
+     * @return the tick subtracted from every record, a whole number of seconds at or before the first one
+     * @note gnuplot converts the ticks to doubles; small offsets convert exactly, whereas present-day epoch nanoseconds would be rounded to 256 ns before the final conversion to seconds
+     */
+    template <typename T1, typename T2>
+    inline int64_t _write_time_data(const std::string filename, const std::vector<T1> &x, const std::vector<T2> &y)
+    {
+        FILE *fout = fopen(filename.c_str(), "wb");
+        if (!fout)
+            throw std::runtime_error("ERROR: Could not open " + filename + " for writing!");
+
+        size_t n = std::min(x.size(), y.size());
+        std::vector<int64_t> ticks(n);
+        std::vector<double> values(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            ticks[i] = _ticks(x[i]);
+            values[i] = static_cast<double>(y[i]);
+        }
+        if (!presorted_x && !_strictly_increasing(ticks))
+        {
+            _sort_unique(ticks, values);
+            n = ticks.size();
+        }
+
+        const int64_t ticks_per_second = T1::period::den;
+        int64_t base = 0;
+        if (n > 0)
+            base = (ticks[0] / ticks_per_second - (ticks[0] % ticks_per_second < 0)) * ticks_per_second;
+
+        const size_t chunk = 4096;
+        std::vector<char> buffer(std::min(n, chunk) * 16);
+        for (size_t start = 0; start < n; start += chunk)
+        {
+            size_t end = std::min(n, start + chunk);
+            for (size_t i = start; i < end; i++)
+            {
+                int64_t t = ticks[i] - base;
+                double v = values[i];
+                memcpy(&buffer[(i - start) * 16], &t, 8);
+                memcpy(&buffer[(i - start) * 16 + 8], &v, 8);
+            }
+            fwrite(buffer.data(), 16, end - start, fout);
+        }
+        fclose(fout);
+        return base;
+    }
+
+    /**
+     * @brief Makes the x-axis a time axis read from seconds since the epoch
+     * @param time_format: strftime-like format of the x tick labels
+     */
+    inline void _write_time_axis(const char *time_format)
+    {
+        fprintf(gnuplotPipe, "set xdata time\n");
+        fprintf(gnuplotPipe, "set timefmt '%%s'\n");
+        fprintf(gnuplotPipe, "set format x '%s' timedate\n", time_format);
+    }
+
+    /**
+     * @brief Writes the plot clause of a line series stored by _write_time_data(), scaling the ticks to seconds
+     * @tparam Period: std::ratio of seconds per tick
+     * @param base: the tick returned by _write_time_data(), added back in seconds
+     */
+    template <typename Period>
+    inline void _time_series(const std::string &filename, const Period, const int64_t base, const char *line_title, const char *line_color, const int marker, const double point_size, const double line_width, const int line_style)
+    {
+        const double seconds = static_cast<double>(Period::num) / Period::den;
+        char x[64];
+        snprintf(x, sizeof(x), "($1*%.17g%+.17g)", seconds, static_cast<double>(base / Period::den * Period::num));
+        if (std::string(line_color) == "auto")
+            fprintf(gnuplotPipe, "\"%s\" binary format='%%int64%%float64' using %s:2 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", filename.c_str(), x, marker, point_size, line_style, line_width, line_title);
+        else
+            fprintf(gnuplotPipe, "\"%s\" binary format='%%int64%%float64' using %s:2 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", filename.c_str(), x, marker, point_size, line_style, line_width, line_color, line_title);
+    }
+
+    /**
+     * @brief Returns the stride that keeps tick labels from overlapping along an axis
+     * @param axis: 'x' for labels side by side, 'y' for labels stacked vertically
+     * @param n: number of labels
+     * @param label_chars: number of characters of the longest label
+     * @param max_ticks: upper bound on the number of labels shown; 0 for none
+     * @note Glyphs are taken as 0.6 font sizes wide and 1.5 font sizes tall, and the axis as 80% of the plot size
+     */
+    int _tick_stride(const char axis, const size_t n, const size_t label_chars, const int max_ticks) const;
+
+    /**
+     * @brief Writes a `set xtics`/`set ytics` command with a readable subset of the labels
+     * @param axis: 'x' or 'y'
+     * @param pos: tick positions; if null, the label indices are used
+     * @param ticks: tick labels
+     * @param max_ticks: maximum number of labels to show; 0 to fit the axis
+     * @param stride: show every `stride`-th label; 0 to derive it from the axis length and `max_ticks`
+     */
+    template <typename T1, typename T2>
+    inline void _write_tics(const char axis, const std::vector<T1> *pos, const std::vector<T2> &ticks, const int max_ticks, const int stride)
+    {
+        if (ticks.empty())
+            return;
+
+        int step = stride;
+        if (step <= 0)
+        {
+            size_t label_chars = 0;
+            for (const auto &tick : ticks)
+                label_chars = std::max(label_chars, std::string(tick).size());
+            step = _tick_stride(axis, ticks.size(), label_chars, max_ticks);
+        }
+
+        std::string tics_cmd = std::string("set ") + axis + "tics (";
+        for (size_t i = 0; i < ticks.size(); i += step)
+        {
+            if (i > 0)
+                tics_cmd += ", ";
+            tics_cmd += "\"" + std::string(ticks[i]) + "\" " + (pos ? std::to_string((*pos)[i]) : std::to_string(i));
+        }
+        tics_cmd += ")\n";
+        fprintf(gnuplotPipe, "%s", tics_cmd.c_str());
+    }
+
+    /**
+     * @brief Writes a length-prefixed blob to a bundle
+     */
+    inline static void _write_blob(FILE *fout, const char *data, const uint64_t size)
+    {
+        fwrite(&size, sizeof(size), 1, fout);
+        fwrite(data, 1, size, fout);
+    }
+
+    /**
+     * @brief Reads a length-prefixed blob of a bundle starting at `offset`, advancing it
+     */
+    static std::string _read_blob(const std::string &bundle, size_t &offset);
+
+    /**
+     * @brief Writes a bundle of the commands written from `begin` on and of the data files numbered from `first_file` on
+     * @return false if the commands could not be read back
+     */
+    bool _write_bundle(FILE *fout, const long begin, const int first_file);
+
+    /**
+     * @brief Unpacks the data files of a bundle into a temporary directory
+     * @param bundle: contents of the bundle file
+     * @param dir: the temporary directory; created if empty, otherwise reused
+     * @param staged: paths of the data files written, appended to
+     * @return the command stream, with data file names rewritten to their staged paths
+     * @note If the bundle is malformed, the files staged by this call and a directory it created are removed before the error is thrown
+     */
+    static std::string _stage_bundle(const std::string &bundle, std::string &dir, std::vector<std::string> &staged);
+
+    /**
+     * @brief Deletes staged data files and their temporary directory; See _stage_bundle()
+     */
+    static void _remove_staged(const std::vector<std::string> &staged, const std::string &dir);
+
+    /**
+     * @brief Makes sends and receives on a socket fail after `timeout_ms` without progress
+     */
+    static bool _set_timeout(const int socket_fd, const int timeout_ms);
+
+    /**
+     * @brief Sends or receives exactly `size` bytes on a socket, without raising SIGPIPE
+     * @return false if the connection was closed or failed
+     */
+    static bool _send_full(const int socket_fd, const void *data, size_t size);
+
+    static bool _recv_full(const int socket_fd, void *data, size_t size);
+
+    /**
+     * @brief Sends a message to the render daemon, with `fd` attached if it is not negative
+     */
+    static bool _send_message(const int socket_fd, const uint64_t kind, const int fd);
+
+    /**
+     * @brief Reads the reply of the render daemon to a message, appending its gnuplot messages to `messages`
+     * @return true if the daemon rendered the job
+     */
+    static bool _read_reply(const int socket_fd, std::string &messages);
+
+    /**
+     * @brief In DAEMON mode, sends the commands and data files written since the last job to the render daemon
+     * @param finish: if true, also closes the output and releases the daemon's worker
+     * @note If the daemon cannot be reached, or fails, everything recorded so far is rendered by a local gnuplot instead
+     */
+    void _daemon_submit(const bool finish);
+
+    /**
+     * @brief Writes the `set terminal` command of the selected terminal
+     */
+    void _write_terminal();
+
+    /**
+     * @brief Returns the vector 0, 1, ..., n - 1, used as x values of plots created without them
+     */
+    inline static std::vector<int> _indices(const size_t n)
+    {
+        std::vector<int> x(n);
+        for (size_t i = 0; i < n; i++)
+            x[i] = i;
+        return x;
+    }
+
+    /**
+     * @brief Converts a plotted value to double; values that are not numbers become NaN, as gnuplot treats them
+     * @overload
+     */
+    template <typename T>
+    inline static double _as_double(const T &value)
+    {
+        return static_cast<double>(value);
+    }
+
+    /**
+     * @brief Converts a plotted value to double; values that are not numbers become NaN, as gnuplot treats them
+     * @overload
+     */
+    inline static double _as_double(const std::string &value)
+    {
+        char *end = nullptr;
+        double v = strtod(value.c_str(), &end);
+        return (end == value.c_str() || *end != '\0') ? NAN : v;
+    }
+
+    /**
+     * @brief In NATIVE mode, checks that nothing but natively supported methods wrote commands since the last one
+     * @return true if the caller should record its settings or series for the native renderer
+     * @note Any other method (logscale, histograms, multiplot, ...) leaves bytes behind in the command stream, which marks the figure for gnuplot until the next reset()
+     */
+    inline bool _native_begin()
+    {
+        if (backend != NATIVE)
+            return false;
+        if (ftell(gnuplotPipe) != native_pos)
+            native_ok = false;
+        return true;
+    }
+
+    /**
+     * @brief In NATIVE mode, marks the commands written so far as accounted for by the native renderer
+     */
+    inline void _native_end()
+    {
+        if (backend == NATIVE && gnuplotPipe)
+            native_pos = ftell(gnuplotPipe);
+    }
+
+    /**
+     * @brief Converts the first `n` values to doubles for the native renderer, adding `shift`; values past the end are 0
+     */
+    template <typename T>
+    inline static std::vector<double> _native_values(const std::vector<T> &values, const size_t n, const double shift = 0.0)
+    {
+        std::vector<double> result(n, 0.0);
+        for (size_t i = 0; i < n && i < values.size(); i++)
+            result[i] = _as_double(values[i]) + shift;
+        return result;
+    }
+
+    /**
+     * @brief Adds a line series to the native figure
+     * @overload
+     */
+    template <typename T1, typename T2>
+    inline void _native_line(const std::string &filename, const std::vector<T1> &x, const std::vector<T2> &y, const double shift, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style, const bool new_figure, const bool set_range = false)
+    {
+        const size_t n = std::min(x.size(), y.size());
+        _native_line(filename, _native_values(x, n, shift), _native_values(y, n), line_title, line_color, marker, point_size, line_width, line_style, new_figure, set_range);
+    }
+
+    /**
+     * @brief Adds a line series to the native figure, marking the figure for gnuplot if its style is not supported
+     */
+    void _native_line(const std::string &filename, std::vector<double> &&x, std::vector<double> &&y, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style, const bool new_figure, const bool set_range);
+
+    /**
+     * @brief Adds a scatter series to the native figure
+     * @overload
+     */
+    template <typename T1, typename T2>
+    inline void _native_scatter(const std::string &filename, const std::vector<T1> &x, const std::vector<T2> &y, const char *point_type, const double point_size, const char *title, const char *point_color, const bool new_figure, const bool set_range = false)
+    {
+        const size_t n = std::min(x.size(), y.size());
+        _native_scatter(filename, _native_values(x, n), _native_values(y, n), point_type, point_size, title, point_color, new_figure, set_range);
+    }
+
+    /**
+     * @brief Adds a scatter series to the native figure; the point type is drawn as a character, as gnuplot does
+     */
+    void _native_scatter(const std::string &filename, std::vector<double> &&x, std::vector<double> &&y, const char *point_type, const double point_size, const char *title, const char *point_color, const bool new_figure, const bool set_range);
+
+    /**
+     * @brief Adds a filled band between two bounds to the native figure
+     * @overload
+     */
+    template <typename T1, typename T2>
+    inline void _native_fill(const std::string &filename, const std::vector<T1> &x, const std::vector<T2> &ub, const std::vector<T2> &lb, const char *color, const double alpha)
+    {
+        const size_t n = std::min(x.size(), ub.size());
+        _native_fill(filename, _native_values(x, n), _native_values(ub, n), _native_values(lb, n), color, alpha);
+    }
+
+    /**
+     * @brief Adds a filled band between two bounds to the native figure
+     */
+    void _native_fill(const std::string &filename, std::vector<double> &&x, std::vector<double> &&ub, std::vector<double> &&lb, const char *color, const double alpha);
+
+    /**
+     * @brief Adds a series of x and y values to the native figure; the caller then sets its kind and style
+     * @param new_figure: true if the series starts a new plot command
+     * @param set_range: true if the axes ranges are to be fitted to this series, as the `stats` commands of set_range do
+     */
+    void _native_add(const std::string &filename, std::vector<double> &&x, std::vector<double> &&y, const char *title, const char *color, const bool new_figure, const bool set_range);
+
+    /**
+     * @brief Creates the FIFO gnuplot renders into for renderToBuffer() and opens it for reading
+     * @note The FIFO is opened read-write, so gnuplot never blocks opening it and it stays open across figures; the end of an image is found from its PNG chunks
+     */
+    void _open_buffer_fifo();
+
+    /**
+     * @brief Reads one PNG image from the buffer FIFO, up to and including its IEND chunk
+     * @param buffer: receives the image; its capacity is reused
+     * @param timeout_ms: time to wait for gnuplot between two reads before giving up with an exception
+     */
+    void _read_png(std::vector<std::byte> &buffer, const int timeout_ms);
+
+    /**
+     * @brief Sends the commands not yet forwarded to gnuplot, starting gnuplot if needed
+     */
+    void _native_forward();
+
+    /**
+     * @brief Inserts a command into the buffered commands at `pos`, which must not have been forwarded to gnuplot yet
+     * @return true if the command was inserted
+     */
+    bool _native_insert(const long pos, const std::string &command);
+
+    /**
+     * @brief Renders the current figure natively, or hands it to gnuplot if it uses anything the native renderer does not support
+     * @param buffer: if not null, receives the figure as PNG bytes instead of the save path; See renderToBuffer()
+     */
+    void _native_plot(std::vector<std::byte> *buffer = nullptr, const int timeout_ms = 30000);
+
+    /**
+     * @brief Drops native state and the commands gnuplot will never need on reset(), keeping the output path
+     */
+    void _native_reset();
+
+    /**
+     * @brief Writes and forgets the commands that undo settings made for the plot command just ended, so they do not leak into the next figure
+     * @note Settings cannot be undone while the plot command is open, since gnuplot only reads them when the command ends
+     */
+    inline void _cleanup_plot()
+    {
+        fputs(plot_cleanup.c_str(), gnuplotPipe);
+        plot_cleanup.clear();
+    }
+};
+
+// Plotting templates; those over int, float, double and int64_t are instantiated once in plotter.cpp with CPPPLOTLIB_COMPILED
+
+template <typename T2>
+CPPPLOTLIB_INLINE void Plotter::createScatterPlot(const std::vector<T2> &y, const char *point_type, const double point_size, const char *title, const char *point_color, const bool set_range)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    if (_native_begin())
+        _native_scatter(filename, _indices(y.size()), y, point_type, point_size, title, point_color, true, set_range);
+    else
+        _write_data(filename, y);
+
+    if (set_range)
+    {
+        fprintf(gnuplotPipe, "stats '%s' using 1:2 nooutput\n", filename.c_str());
+        fprintf(gnuplotPipe, "x_offset = (STATS_max_x - STATS_min_x) * 0.05\n");
+        fprintf(gnuplotPipe, "y_offset = (STATS_max_y - STATS_min_y) * 0.05\n");
+        fprintf(gnuplotPipe, "set xrange [STATS_min_x - x_offset:STATS_max_x + x_offset]\n");
+        fprintf(gnuplotPipe, "set yrange [STATS_min_y - y_offset:STATS_max_y + y_offset]\n");
+    }
+
+    fprintf(gnuplotPipe, "plot ");
+    if (std::string(point_color) == "auto")
+        fprintf(gnuplotPipe, "\"%s\" using 1:2 with points pointtype '%s' pointsize %f title '%s'", filename.c_str(), point_type, point_size, title);
+    else
+        fprintf(gnuplotPipe, "\"%s\" using 1:2 with points pointtype '%s' pointsize %f linecolor '%s' title '%s'", filename.c_str(), point_type, point_size, point_color, title);
+
+    _native_end();
+    cnt_files++;
+}
+
+template <typename T1, typename T2>
+CPPPLOTLIB_INLINE void Plotter::createScatterPlot(const std::vector<T1> &x, const std::vector<T2> &y, const char *point_type, const double point_size, const char *title, const char *point_color, const bool set_range)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    if (_native_begin())
+        _native_scatter(filename, x, y, point_type, point_size, title, point_color, true, set_range);
+    else
+        _write_data(filename, x, y, static_cast<T1>(0));
+
+    if (set_range)
+    {
+        fprintf(gnuplotPipe, "stats '%s' using 1:2 nooutput\n", filename.c_str());
+        fprintf(gnuplotPipe, "x_offset = (STATS_max_x - STATS_min_x) * 0.05\n");
+        fprintf(gnuplotPipe, "y_offset = (STATS_max_y - STATS_min_y) * 0.05\n");
+        fprintf(gnuplotPipe, "set xrange [STATS_min_x - x_offset:STATS_max_x + x_offset]\n");
+        fprintf(gnuplotPipe, "set yrange [STATS_min_y - y_offset:STATS_max_y + y_offset]\n");
+    }
+
+    fprintf(gnuplotPipe, "plot ");
+    if (std::string(point_color) == "auto")
+        fprintf(gnuplotPipe, "\"%s\" using 1:2 with points pointtype '%s' pointsize %f title '%s'", filename.c_str(), point_type, point_size, title);
+    else
+        fprintf(gnuplotPipe, "\"%s\" using 1:2 with points pointtype '%s' pointsize %f linecolor '%s' title '%s'", filename.c_str(), point_type, point_size, point_color, title);
+
+    _native_end();
+    cnt_files++;
+}
+
+template <typename T2>
+CPPPLOTLIB_INLINE void Plotter::addScatterPlot(const std::vector<T2> &y, const char *point_type, const double point_size, const char *title, const char *point_color)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    if (_native_begin())
+        _native_scatter(filename, _indices(y.size()), y, point_type, point_size, title, point_color, false);
+    else
+        _write_data(filename, y);
+
+    if (std::string(point_color) == "auto")
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2 with points pointtype '%s' pointsize %f title '%s'", filename.c_str(), point_type, point_size, title);
+    else
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2 with points pointtype '%s' pointsize %f linecolor '%s' title '%s'", filename.c_str(), point_type, point_size, point_color, title);
+
+    _native_end();
+    cnt_files++;
+}
+
+template <typename T1, typename T2>
+CPPPLOTLIB_INLINE void Plotter::addScatterPlot(const std::vector<T1> &x, const std::vector<T2> &y, const char *point_type, const double point_size, const char *title, const char *point_color)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    if (_native_begin())
+        _native_scatter(filename, x, y, point_type, point_size, title, point_color, false);
+    else
+        _write_data(filename, x, y, static_cast<T1>(0));
+
+    if (std::string(point_color) == "auto")
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2 with points pointtype '%s' pointsize %f title '%s'", filename.c_str(), point_type, point_size, title);
+    else
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2 with points pointtype '%s' pointsize %f linecolor '%s' title '%s'", filename.c_str(), point_type, point_size, point_color, title);
+
+    _native_end();
+    cnt_files++;
+}
+
+template <typename T2>
+CPPPLOTLIB_INLINE void Plotter::createPlot(const std::vector<T2> &y, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style, const bool set_range)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    if (_native_begin())
+        _native_line(filename, _indices(y.size()), y, 0.0, line_title, line_color, marker, point_size, line_width, line_style, true, set_range);
+    else
+        _write_data(filename, y);
+
+    if (set_range)
+    {
+        fprintf(gnuplotPipe, "stats '%s' using 1:2 nooutput\n", filename.c_str());
+        fprintf(gnuplotPipe, "x_offset = (STATS_max_x - STATS_min_x) * 0.05\n");
+        fprintf(gnuplotPipe, "y_offset = (STATS_max_y - STATS_min_y) * 0.05\n");
+        fprintf(gnuplotPipe, "set xrange [STATS_min_x - x_offset:STATS_max_x + x_offset]\n");
+        fprintf(gnuplotPipe, "set yrange [STATS_min_y - y_offset:STATS_max_y + y_offset]\n");
+    }
+    fprintf(gnuplotPipe, "plot ");
+    if (std::string(line_color) == "auto")
+        fprintf(gnuplotPipe, "\"%s\" using 1:2 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_title);
+    else
+        fprintf(gnuplotPipe, "\"%s\" using 1:2 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_color, line_title);
+
+    _native_end();
+    cnt_files++;
+}
+
+template <typename T1, typename T2>
+CPPPLOTLIB_INLINE void Plotter::createPlot(const std::vector<T1> &x, const std::vector<T2> &y, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style, const T1 shift, const bool set_range)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    std::vector<double> xs, ys;
+    const bool sorted = _sorted_xy(x, y, static_cast<double>(shift), xs, ys);
+    if (_native_begin())
+    {
+        if (sorted)
+            _native_line(filename, x, y, static_cast<double>(shift), line_title, line_color, marker, point_size, line_width, line_style, true, set_range);
+        else
+            _native_line(filename, std::move(xs), std::move(ys), line_title, line_color, marker, point_size, line_width, line_style, true, set_range);
+    }
+    else if (sorted)
+        _write_data(filename, x, y, shift);
+    else
+        _write_data(filename, xs, ys, 0.0, std::numeric_limits<double>::max_digits10);
+
+    if (set_range)
+    {
+        fprintf(gnuplotPipe, "stats '%s' using 1:2 nooutput\n", filename.c_str());
+        fprintf(gnuplotPipe, "x_offset = (STATS_max_x - STATS_min_x) * 0.05\n");
+        fprintf(gnuplotPipe, "y_offset = (STATS_max_y - STATS_min_y) * 0.05\n");
+        fprintf(gnuplotPipe, "set xrange [STATS_min_x - x_offset:STATS_max_x + x_offset]\n");
+        fprintf(gnuplotPipe, "set yrange [STATS_min_y - y_offset:STATS_max_y + y_offset]\n");
+    }
+
+    fprintf(gnuplotPipe, "plot ");
+    if (std::string(line_color) == "auto")
+        fprintf(gnuplotPipe, "\"%s\" using 1:2 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_title);
+    else
+        fprintf(gnuplotPipe, "\"%s\" using 1:2 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_color, line_title);
+
+    _native_end();
+    cnt_files++;
+}
+
+template <typename T2>
+CPPPLOTLIB_INLINE void Plotter::addPlot(const std::vector<T2> &y, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    if (_native_begin())
+        _native_line(filename, _indices(y.size()), y, 0.0, line_title, line_color, marker, point_size, line_width, line_style, false);
+    else
+        _write_data(filename, y);
+
+    if (std::string(line_color) == "auto")
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_title);
+    else
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_color, line_title);
+
+    _native_end();
+    cnt_files++;
+}
+
+template <typename T1, typename T2>
+CPPPLOTLIB_INLINE void Plotter::addPlot(const std::vector<T1> &x, const std::vector<T2> &y, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style, const T1 shift)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    std::vector<double> xs, ys;
+    const bool sorted = _sorted_xy(x, y, static_cast<double>(shift), xs, ys);
+    if (_native_begin())
+    {
+        if (sorted)
+            _native_line(filename, x, y, static_cast<double>(shift), line_title, line_color, marker, point_size, line_width, line_style, false);
+        else
+            _native_line(filename, std::move(xs), std::move(ys), line_title, line_color, marker, point_size, line_width, line_style, false, false);
+    }
+    else if (sorted)
+        _write_data(filename, x, y, shift);
+    else
+        _write_data(filename, xs, ys, 0.0, std::numeric_limits<double>::max_digits10);
+
+    if (std::string(line_color) == "auto")
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_title);
+    else
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2 with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", filename.c_str(), marker, point_size, line_style, line_width, line_color, line_title);
+
+    _native_end();
+    cnt_files++;
+}
+
+template <typename Clock, typename Duration, typename T2>
+CPPPLOTLIB_INLINE void Plotter::createPlot(const std::vector<std::chrono::time_point<Clock, Duration>> &x, const std::vector<T2> &y, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style, const char *time_format)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    const int64_t base = _write_time_data(filename, x, y);
+
+    _write_time_axis(time_format);
+    fprintf(gnuplotPipe, "plot ");
+    _time_series(filename, typename Duration::period(), base, line_title, line_color, marker, point_size, line_width, line_style);
+
+    cnt_files++;
+}
+
+template <typename Rep, typename Period, typename T2>
+CPPPLOTLIB_INLINE void Plotter::createPlot(const std::vector<std::chrono::duration<Rep, Period>> &x, const std::vector<T2> &y, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style, const char *time_format)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    const int64_t base = _write_time_data(filename, x, y);
+
+    fprintf(gnuplotPipe, "set xtics time\n");
+    fprintf(gnuplotPipe, "set format x '%s'\n", time_format);
+    fprintf(gnuplotPipe, "plot ");
+    _time_series(filename, Period(), base, line_title, line_color, marker, point_size, line_width, line_style);
+
+    cnt_files++;
+}
+
+template <typename Clock, typename Duration, typename T2>
+CPPPLOTLIB_INLINE void Plotter::addPlot(const std::vector<std::chrono::time_point<Clock, Duration>> &x, const std::vector<T2> &y, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    const int64_t base = _write_time_data(filename, x, y);
+
+    fprintf(gnuplotPipe, ", ");
+    _time_series(filename, typename Duration::period(), base, line_title, line_color, marker, point_size, line_width, line_style);
+
+    cnt_files++;
+}
+
+template <typename Rep, typename Period, typename T2>
+CPPPLOTLIB_INLINE void Plotter::addPlot(const std::vector<std::chrono::duration<Rep, Period>> &x, const std::vector<T2> &y, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    const int64_t base = _write_time_data(filename, x, y);
+
+    fprintf(gnuplotPipe, ", ");
+    _time_series(filename, Period(), base, line_title, line_color, marker, point_size, line_width, line_style);
+
+    cnt_files++;
+}
+
+template <typename T2>
+CPPPLOTLIB_INLINE void Plotter::fillBetween(const std::vector<T2> &ub, const std::vector<T2> &lb, const char *color, const double alpha)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    std::vector<int> x = _indices(ub.size());
+    if (_native_begin())
+        _native_fill(filename, x, ub, lb, color, alpha);
+    else
+        _write_data(filename, x, ub, lb);
+
+    if (std::string(color) == "auto")
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2:3 with filledcurves fill transparent solid %f title ''", filename.c_str(), alpha);
+    else
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2:3 with filledcurves linecolor '%s' fill transparent solid %f title ''", filename.c_str(), color, alpha);
+
+    _native_end();
+    cnt_files++;
+}
+
+template <typename T1, typename T2>
+CPPPLOTLIB_INLINE void Plotter::fillBetween(const std::vector<T1> &x, const std::vector<T2> &ub, const std::vector<T2> &lb, const char *color, const double alpha)
+{
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    if (_native_begin())
+        _native_fill(filename, x, ub, lb, color, alpha);
+    else
+        _write_data(filename, x, ub, lb);
+
+    if (std::string(color) == "auto")
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2:3 with filledcurves fill transparent solid %f title ''", filename.c_str(), alpha);
+    else
+        fprintf(gnuplotPipe, ", \"%s\" using 1:2:3 with filledcurves linecolor '%s' fill transparent solid %f title ''", filename.c_str(), color, alpha);
+
+    _native_end();
+    cnt_files++;
+}
+
+#if !defined(CPPPLOTLIB_COMPILED) || defined(CPPPLOTLIB_IMPLEMENTATION)
+
+CPPPLOTLIB_INLINE Plotter::Plotter(int size_x, int size_y, int fontSize, bool debugMode, Backend backendMode)
+{
+    backend = backendMode;
+    if (backend == NATIVE || backend == CAPTURE || backend == DAEMON)
+        gnuplotPipe = tmpfile();
+    else if (debugMode)
+        gnuplotPipe = fopen("debug_plotter.txt", "w");
+    else
+        gnuplotPipe = popen("gnuplot -persistent", "w");
+
+    debug = debugMode;
+    native = new NativeRenderer();
+    plot_width = native->width = size_x;
+    plot_height = native->height = size_y;
+    font_size = native->font_size = fontSize;
+
+    if (gnuplotPipe)
+        _write_terminal();
+    else
+        std::cerr << "Could not set up pipe with gnuplot" << std::endl;
+    _native_end();
+}
+
+CPPPLOTLIB_INLINE Plotter::~Plotter()
+{
+    if (backend == DAEMON && gnuplotPipe)
+        _daemon_submit(true);
+
+    // gnuplot may still hold the buffer FIFO; closing our end first keeps it from blocking on a full FIFO while we wait for it to exit
+    if (buffer_fd >= 0)
+        close(buffer_fd);
+
+    if (backend != GNUPLOT)
+    {
+        if (gnuplotPipe)
+            fclose(gnuplotPipe);
+        gnuplotPipe = gnuplotProcess;
+    }
+
+    if (gnuplotPipe)
+    {
+        fflush(gnuplotPipe);
+        pclose(gnuplotPipe);
+    }
+
+    if (!debug)
+        for (int i = 0; i < cnt_files; i++)
+            unlink((std::to_string(i) + ".dat").c_str());
+
+    if (!buffer_fifo.empty())
+    {
+        unlink(buffer_fifo.c_str());
+        rmdir(buffer_fifo.substr(0, buffer_fifo.rfind('/')).c_str());
+    }
+    delete native;
+}
+
+CPPPLOTLIB_INLINE void Plotter::reset(int size_x, int size_y, int fontSize)
+{
+    plot_width = native->width = size_x;
+    plot_height = native->height = size_y;
+    font_size = native->font_size = fontSize;
+    if (backend == NATIVE)
+        _native_reset();
+
+    plot_cleanup.clear();
+    cb_range = "[*:*]";
+    palette_levels = 0;
+    fflush(gnuplotPipe);
+    fprintf(gnuplotPipe, "\nreset\n");
+    _write_terminal();
+    _native_end();
+}
+
+CPPPLOTLIB_INLINE void Plotter::plot()
+{
+    if (backend == NATIVE)
+    {
+        _native_plot();
+        return;
+    }
+
+    if (backend == DAEMON && gnuplotPipe)
+    {
+        fprintf(gnuplotPipe, "\n");
+        _cleanup_plot();
+        _daemon_submit(false);
+        return;
+    }
+
+    if (gnuplotPipe)
+    {
+        fprintf(gnuplotPipe, "\n");
+        _cleanup_plot();
+        fflush(gnuplotPipe);
+        if (buffer_output && !in_multiplot && !debug)
+            _read_png(scratch_png, 30000);
+    }
+}
+
+CPPPLOTLIB_INLINE void Plotter::set_bufferOutput()
+{
+    if (backend != GNUPLOT)
+        return;
+    if (output_terminal != PNGCAIRO && output_terminal != PNG && output_terminal != DRAFT)
+        throw std::runtime_error("ERROR: Rendering to a buffer needs a PNG terminal!");
+    _open_buffer_fifo();
+    fprintf(gnuplotPipe, "\nset output '%s'\n", buffer_fifo.c_str());
+    buffer_output = true;
+}
+
+CPPPLOTLIB_INLINE void Plotter::renderToBuffer(std::vector<std::byte> &buffer, const int timeout_ms)
+{
+    if (backend == CAPTURE || backend == DAEMON)
+        throw std::runtime_error("ERROR: renderToBuffer is not available with Plotter::CAPTURE or Plotter::DAEMON!");
+    if (output_terminal != PNGCAIRO && output_terminal != PNG && output_terminal != DRAFT)
+        throw std::runtime_error("ERROR: Rendering to a buffer needs a PNG terminal!");
+
+    buffer.clear();
+    if (backend == NATIVE)
+    {
+        _native_plot(&buffer, timeout_ms);
+        return;
+    }
+
+    // The plot command has already streamed to gnuplot, so it can only be routed to the FIFO by a `set output` sent before it;
+    // otherwise the figure is finished as plot() would, so that the next figure starts on a fresh command
+    if (!buffer_output)
+    {
+        plot();
+        throw std::runtime_error("ERROR: Call set_bufferOutput() before composing a figure to render it to a buffer!");
+    }
+    fprintf(gnuplotPipe, "\n");
+    _cleanup_plot();
+    if (in_multiplot)
+    {
+        fprintf(gnuplotPipe, "unset multiplot\n");
+        in_multiplot = false;
+    }
+    fflush(gnuplotPipe);
+
+    if (!debug)
+        _read_png(buffer, timeout_ms);
+}
+
+CPPPLOTLIB_INLINE void Plotter::saveBundle(const char *bundle_path)
+{
+    if (backend != CAPTURE)
+        throw std::runtime_error("ERROR: saveBundle needs a Plotter constructed with Plotter::CAPTURE!");
+
+    FILE *fout = fopen(bundle_path, "wb");
+    if (!fout)
+        throw std::runtime_error(std::string("ERROR: Could not open ") + bundle_path + " for writing!");
+
+    const bool written = _write_bundle(fout, 0, 0);
+    if (fclose(fout) != 0 || !written)
+        throw std::runtime_error(std::string("ERROR: Could not write ") + bundle_path + "!");
+}
+
+CPPPLOTLIB_INLINE void Plotter::replayBundle(const char *bundle_path, bool debugMode)
+{
+    std::ifstream fin(bundle_path, std::ios::binary);
+    if (!fin)
+        throw std::runtime_error(std::string("ERROR: Could not open ") + bundle_path + "!");
+    std::string bundle((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+    std::vector<std::string> staged;
+    std::string dir;
+    std::string commands = _stage_bundle(bundle, dir, staged);
+
+    FILE *gnuplot = debugMode ? fopen("debug_plotter.txt", "w") : popen("gnuplot", "w");
+    if (gnuplot)
+    {
+        fwrite(commands.data(), 1, commands.size(), gnuplot);
+        fprintf(gnuplot, "\n");
+        if (debugMode)
+            fclose(gnuplot);
+        else
+            pclose(gnuplot);
+    }
+    else
+        std::cerr << "Could not set up pipe with gnuplot" << std::endl;
+
+    if (!debugMode)
+        _remove_staged(staged, dir);
+}
+
+CPPPLOTLIB_INLINE void Plotter::unset_multiplot()
+{
+    fprintf(gnuplotPipe, "unset multiplot\n");
+    if (in_multiplot && buffer_output && !debug)
+    {
+        fflush(gnuplotPipe);
+        _read_png(scratch_png, 30000);
+    }
+    in_multiplot = false;
+}
+
+CPPPLOTLIB_INLINE void Plotter::set_xlabel(const char *label)
+{
+    if (_native_begin())
+        native->xlabel = label;
+    if (gnuplotPipe)
+        fprintf(gnuplotPipe, "\nset xlabel '%s'\n", label);
+    _native_end();
+}
+
+CPPPLOTLIB_INLINE void Plotter::set_ylabel(const char *label)
+{
+    if (_native_begin())
+        native->ylabel = label;
+    if (gnuplotPipe)
+        fprintf(gnuplotPipe, "\nset ylabel '%s'\n", label);
+    _native_end();
+}
+
+CPPPLOTLIB_INLINE void Plotter::set_title(const char *title)
+{
+    if (_native_begin())
+        native->title = title;
+    if (gnuplotPipe)
+        fprintf(gnuplotPipe, "\nset title '%s'\n", title);
+    _native_end();
+}
+
+CPPPLOTLIB_INLINE void Plotter::show_grid(bool show_grid)
+{
+    if (_native_begin())
+        native->grid = show_grid;
+    if (gnuplotPipe)
+    {
+        if (show_grid)
+            fprintf(gnuplotPipe, "set grid\n");
+        else
+            fprintf(gnuplotPipe, "unset grid\n");
+    }
+    _native_end();
+}
+
+CPPPLOTLIB_INLINE void Plotter::set_legend(const char *position)
+{
+    if (_native_begin())
+    {
+        native->legend = native->legend_box = true;
+        native->legend_left = std::string(position).find("left") != std::string::npos;
+    }
+    if (gnuplotPipe)
+        fprintf(gnuplotPipe, "set key box %s\n", position);
+    _native_end();
+}
+
+CPPPLOTLIB_INLINE void Plotter::unset_legend()
+{
+    if (_native_begin())
+        native->legend = false;
+    if (gnuplotPipe)
+        fprintf(gnuplotPipe, "unset key\n");
+    _native_end();
+}
+
+CPPPLOTLIB_INLINE void Plotter::set_xlim(double min, double max)
+{
+    if (_native_begin())
+    {
+        native->has_xlim = true;
+        native->xmin = min;
+        native->xmax = max;
+    }
+    if (gnuplotPipe)
+        fprintf(gnuplotPipe, "set xrange [%f:%f]\n", min, max);
+    _native_end();
+}
+
+CPPPLOTLIB_INLINE void Plotter::set_ylim(double min, double max)
+{
+    if (_native_begin())
+    {
+        native->has_ylim = true;
+        native->ymin = min;
+        native->ymax = max;
+    }
+    if (gnuplotPipe)
+        fprintf(gnuplotPipe, "set yrange [%f:%f]\n", min, max);
+    _native_end();
+}
+
+CPPPLOTLIB_INLINE void Plotter::set_colormap(const Colormap colormap, const int levels)
+{
+    if (!gnuplotPipe)
+        return;
+
+    switch (colormap)
+    {
+    case GRAY:
+        fprintf(gnuplotPipe, "set palette gray\n");
+        break;
+    case VIRIDIS:
+        fprintf(gnuplotPipe, "set palette defined (0 '#440154', 1 '#472c7a', 2 '#3b518b', 3 '#2c718e', 4 '#21908d', 5 '#27ad81', 6 '#5cc863', 7 '#aadc32', 8 '#fde725')\n");
+        break;
+    case JET:
+        fprintf(gnuplotPipe, "set palette defined (0 '#000090', 1 '#000fff', 2 '#0090ff', 3 '#0fffee', 4 '#90ff70', 5 '#ffee00', 6 '#ff7000', 7 '#ee0000', 8 '#7f0000')\n");
+        break;
+    case HOT:
+        fprintf(gnuplotPipe, "set palette rgbformulae 21, 22, 23\n");
+        break;
+    case COOLWARM:
+        fprintf(gnuplotPipe, "set palette defined (0 '#3b4cc0', 1 '#dddddd', 2 '#b40426')\n");
+        break;
+    }
+
+    // 0 also undoes the levels of an earlier colormap
+    palette_levels = std::max(0, levels);
+    fprintf(gnuplotPipe, "set palette maxcolors %d\n", palette_levels);
+}
+
+CPPPLOTLIB_INLINE void Plotter::show_colorbar(bool show_colorbar)
+{
+    if (gnuplotPipe)
+    {
+        if (show_colorbar)
+            fprintf(gnuplotPipe, "set colorbox\n");
+        else
+            fprintf(gnuplotPipe, "unset colorbox\n");
+    }
+}
+
+CPPPLOTLIB_INLINE void Plotter::createBoxPlot(const std::vector<std::string> &x, const std::vector<std::vector<double>> &y, const bool show_xticks, const double box_width, const char *color)
+{
+    fprintf(gnuplotPipe, "set style data boxplot\n");
+    fprintf(gnuplotPipe, "set style boxplot outliers pointtype 7\n");
+
+    if (std::string(color) != "auto")
+        for (int i = 0; i < y.size(); i++)
+            fprintf(gnuplotPipe, "set linetype %d lc '%s' lw 2\n", i + 1, color);
+
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    std::ofstream fout(filename);
+    for (int j = 0; j < y[0].size() - 1; j++)
+    {
+        for (int i = 0; i < y.size() - 1; i++)
+            fout << y[i][j] << " ";
+        fout << y.back()[j] << "\n";
+    }
+    fout.close();
+
+    fprintf(gnuplotPipe, "plot '%s' using (1):1 title '' with boxplot,", filename.c_str());
+    for (int i = 1; i < y.size(); i++)
+        fprintf(gnuplotPipe, "'' using (%d):%d title '' with boxplot,", i + 1, i + 1);
+
+    fprintf(gnuplotPipe, "\n");
+    fprintf(gnuplotPipe, "unset style boxplot\n");
+    cnt_files++;
+}
+
+CPPPLOTLIB_INLINE void Plotter::createCandlestickPlot(const OHLC &ohlc, const bool financebars, const bool show_volume, const char *time_format, const char *up_color, const char *down_color)
+{
+    const std::vector<OHLC::Bar> &bars = ohlc.bars();
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    FILE *fout = fopen(filename.c_str(), "wb");
+    if (!fout)
+        throw std::runtime_error("ERROR: Could not open " + filename + " for writing!");
+    // Start times are written from a whole second, as in _write_time_data()
+    const int64_t base = bars.empty() ? 0 : (bars[0].start / 1000000000 - (bars[0].start % 1000000000 < 0)) * 1000000000;
+    double max_volume = 0.0;
+    for (const OHLC::Bar &bar : bars)
+    {
+        const double values[7] = {bar.open, bar.low, bar.high, bar.close, bar.whisker_low, bar.whisker_high, bar.volume};
+        const int64_t start = bar.start - base;
+        fwrite(&start, sizeof(int64_t), 1, fout);
+        fwrite(values, sizeof(double), 7, fout);
+        max_volume = std::max(max_volume, bar.volume);
+    }
+    fclose(fout);
+
+    const double bucket = ohlc.bucketLength() * 1e-9;
+    char x[64];
+    snprintf(x, sizeof(x), "($1*1e-9%+.17g)", static_cast<double>(base / 1000000000) + bucket / 2);
+
+    _write_time_axis(time_format);
+    fprintf(gnuplotPipe, "set boxwidth %.17g absolute\n", 0.7 * bucket);
+    const bool volume = show_volume && max_volume > 0.0;
+    if (volume)
+    {
+        fprintf(gnuplotPipe, "set ytics nomirror\n");
+        fprintf(gnuplotPipe, "set y2tics\n");
+        fprintf(gnuplotPipe, "set y2range [0:%.17g]\n", 4 * max_volume);
+    }
+
+    const char *format = "%int64%float64%float64%float64%float64%float64%float64%float64";
+    fprintf(gnuplotPipe, "plot ");
+    if (volume)
+        fprintf(gnuplotPipe, "\"%s\" binary format='%s' using %s:8 axes x1y2 with boxes fill solid 0.3 noborder linecolor 'gray' title 'volume', ", filename.c_str(), format, x);
+    if (financebars)
+    {
+        fprintf(gnuplotPipe, "\"%s\" binary format='%s' using %s:($5 >= $2 ? $2 : 1/0):3:4:5 with financebars linecolor '%s' title '', ", filename.c_str(), format, x, up_color);
+        fprintf(gnuplotPipe, "\"%s\" binary format='%s' using %s:($5 < $2 ? $2 : 1/0):3:4:5 with financebars linecolor '%s' title ''", filename.c_str(), format, x, down_color);
+    }
+    else
+    {
+        fprintf(gnuplotPipe, "\"%s\" binary format='%s' using %s:($5 >= $2 ? $2 : 1/0):6:7:5 with candlesticks fill solid 0.8 border linecolor '%s' title '', ", filename.c_str(), format, x, up_color);
+        fprintf(gnuplotPipe, "\"%s\" binary format='%s' using %s:($5 < $2 ? $2 : 1/0):6:7:5 with candlesticks fill solid 0.8 border linecolor '%s' title ''", filename.c_str(), format, x, down_color);
+    }
+
+    cnt_files++;
+}
+
+CPPPLOTLIB_INLINE void Plotter::createPlot(const SeriesIndex &index, const double x_min, const double x_max, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style)
+{
+    std::vector<double> xs, ys;
+    index.query(x_min, x_max, plot_width, xs, ys);
+    set_xlim(x_min, x_max);
+
+    // The minimum and maximum of a bucket may share an x value, and must not be averaged into one point
+    const bool presorted = presorted_x;
+    presorted_x = true;
+    createPlot(xs, ys, line_title, line_color, marker, point_size, line_width, line_style);
+    presorted_x = presorted;
+}
+
+CPPPLOTLIB_INLINE void Plotter::addPlot(const SeriesIndex &index, const double x_min, const double x_max, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style)
+{
+    std::vector<double> xs, ys;
+    index.query(x_min, x_max, plot_width, xs, ys);
+
+    const bool presorted = presorted_x;
+    presorted_x = true;
+    addPlot(xs, ys, line_title, line_color, marker, point_size, line_width, line_style);
+    presorted_x = presorted;
+}
+
+CPPPLOTLIB_INLINE void Plotter::plotDataset(const Dataset &data, const int x_column, const int y_column, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style, const bool set_range)
+{
+    _check_dataset(data, x_column, y_column);
+    const std::string source = _dataset_using(data, x_column, y_column);
+    if (set_range)
+    {
+        fprintf(gnuplotPipe, "stats %s using %d:%d nooutput\n", _dataset_source(data).c_str(), x_column, y_column);
+        fprintf(gnuplotPipe, "x_offset = (STATS_max_x - STATS_min_x) * 0.05\n");
+        fprintf(gnuplotPipe, "y_offset = (STATS_max_y - STATS_min_y) * 0.05\n");
+        fprintf(gnuplotPipe, "set xrange [STATS_min_x - x_offset:STATS_max_x + x_offset]\n");
+        fprintf(gnuplotPipe, "set yrange [STATS_min_y - y_offset:STATS_max_y + y_offset]\n");
+    }
+
+    fprintf(gnuplotPipe, "plot ");
+    _dataset_series(source, line_title, line_color, marker, point_size, line_width, line_style);
+}
+
+CPPPLOTLIB_INLINE std::string Plotter::_dataset_using(const Dataset &data, const int x_column, const int y_column)
+{
+    const bool increasing = x_column <= static_cast<int>(data.increasing.size()) && data.increasing[x_column - 1];
+    if (presorted_x || increasing)
+        return _dataset_source(data) + " using " + std::to_string(x_column) + ":" + std::to_string(y_column);
+
+    FILE *fin = fopen(data.filename.c_str(), "rb");
+    if (!fin)
+        throw std::runtime_error("ERROR: Could not open " + data.filename + " for reading!");
+    std::vector<double> xs(data.n_rows), ys(data.n_rows), row(data.n_columns);
+    for (int i = 0; i < data.n_rows; i++)
+    {
+        if (fread(row.data(), sizeof(double), data.n_columns, fin) != static_cast<size_t>(data.n_columns))
+        {
+            fclose(fin);
+            throw std::runtime_error("ERROR: Could not read " + data.filename + "!");
+        }
+        xs[i] = row[x_column - 1];
+        ys[i] = row[y_column - 1];
+    }
+    fclose(fin);
+
+    _sort_unique(xs, ys);
+    std::string filename = std::to_string(cnt_files) + ".dat";
+    _write_data(filename, xs, ys, 0.0, std::numeric_limits<double>::max_digits10);
+    cnt_files++;
+    return "\"" + filename + "\" using 1:2";
+}
+
+CPPPLOTLIB_INLINE void Plotter::_dataset_series(const std::string &source, const char *line_title, const char *line_color, const int marker, const double point_size, const double line_width, const int line_style)
+{
+    if (std::string(line_color) == "auto")
+        fprintf(gnuplotPipe, "%s with linespoints pointtype %d pointsize %f dashtype %d linewidth %f title '%s'", source.c_str(), marker, point_size, line_style, line_width, line_title);
+    else
+        fprintf(gnuplotPipe, "%s with linespoints pointtype %d pointsize %f dashtype %d linewidth %f linecolor '%s' title '%s'", source.c_str(), marker, point_size, line_style, line_width, line_color, line_title);
+}
+
+CPPPLOTLIB_INLINE std::vector<size_t> Plotter::_simplify_polyline(const std::vector<double> &x, const std::vector<double> &y, const std::vector<double> &z, const size_t budget)
+{
+    const size_t n = x.size();
+    if (n <= 2 || budget >= n)
+    {
+        std::vector<size_t> all(n);
+        for (size_t i = 0; i < n; i++)
+            all[i] = i;
+        return all;
+    }
+
+    double scale[3];
+    const std::vector<double> *axes[3] = {&x, &y, &z};
+    for (int a = 0; a < 3; a++)
+    {
+        auto range = std::minmax_element(axes[a]->begin(), axes[a]->end());
+        scale[a] = *range.second > *range.first ? 1.0 / (*range.second - *range.first) : 1.0;
+    }
+
+    struct Segment
+    {
+        double error;
+        size_t first, last, split;
+        bool operator<(const Segment &other) const { return error < other.error; }
+    };
+    auto farthest = [&](size_t first, size_t last)
+    {
+        Segment segment = {0.0, first, last, first};
+        double d[3], len2 = 0.0;
+        for (int a = 0; a < 3; a++)
+        {
+            d[a] = ((*axes[a])[last] - (*axes[a])[first]) * scale[a];
+            len2 += d[a] * d[a];
+        }
+        for (size_t i = first + 1; i < last; i++)
+        {
+            double p[3], dot = 0.0, dist2 = 0.0;
+            for (int a = 0; a < 3; a++)
+            {
+                p[a] = ((*axes[a])[i] - (*axes[a])[first]) * scale[a];
+                dot += p[a] * d[a];
+            }
+            double t = len2 > 0.0 ? std::max(0.0, std::min(1.0, dot / len2)) : 0.0;
+            for (int a = 0; a < 3; a++)
+                dist2 += (p[a] - t * d[a]) * (p[a] - t * d[a]);
+            if (dist2 > segment.error)
+            {
+                segment.error = dist2;
+                segment.split = i;
+            }
+        }
+        return segment;
+    };
+
+    std::vector<size_t> keep = {0, n - 1};
+    std::priority_queue<Segment> queue;
+    queue.push(farthest(0, n - 1));
+    while (keep.size() < std::max<size_t>(budget, 2) && !queue.empty() && queue.top().error > 0.0)
+    {
+        Segment segment = queue.top();
+        queue.pop();
+        keep.push_back(segment.split);
+        if (segment.split - segment.first > 1)
+            queue.push(farthest(segment.first, segment.split));
+        if (segment.last - segment.split > 1)
+            queue.push(farthest(segment.split, segment.last));
+    }
+    std::sort(keep.begin(), keep.end());
+    return keep;
+}
+
+CPPPLOTLIB_INLINE void Plotter::_rolling_mean_std(const std::vector<double> &y, const size_t window, const double spread, std::vector<double> &center, std::vector<double> &lb, std::vector<double> &ub)
+{
+    _parallel_chunks(y.size(), [&](size_t first, size_t last)
+                     {
+        const size_t begin = first >= window ? first - window : 0;
+        double ref = 0.0;
+        for (size_t i = begin; i < last; i++)
+            if (std::isfinite(y[i]))
+            {
+                ref = y[i];
+                break;
+            }
+
+        // Values that are not finite are left out of the window; once in the sums, they would turn them into NaN for good
+        double sum = 0.0, sum2 = 0.0;
+        long count = 0;
+        auto update = [&](size_t i, int delta)
+        {
+            if (std::isfinite(y[i]))
+            {
+                sum += delta * (y[i] - ref);
+                sum2 += delta * (y[i] - ref) * (y[i] - ref);
+                count += delta;
+            }
+        };
+
+        for (size_t i = begin; i < first; i++)
+            update(i, 1);
+        for (size_t i = first; i < last; i++)
+        {
+            update(i, 1);
+            if (i >= window)
+                update(i - window, -1);
+            if (count == 0)
+            {
+                center[i] = lb[i] = ub[i] = NAN;
+                continue;
+            }
+            const double mean = sum / count;
+            const double sd = std::sqrt(std::max(0.0, sum2 / count - mean * mean));
+            center[i] = mean + ref;
+            lb[i] = center[i] - spread * sd;
+            ub[i] = center[i] + spread * sd;
+        } });
+}
+
+CPPPLOTLIB_INLINE void Plotter::_rolling_quantiles(const std::vector<double> &y, const size_t window, const double lower, const double upper, std::vector<double> &center, std::vector<double> &lb, std::vector<double> &ub)
+{
+    _parallel_chunks(y.size(), [&](size_t first, size_t last)
+                     {
+        // Ranks are taken over the chunk and the window before it only, so the tree is sized to them; NaN values get no rank and are left out of the window
+        const size_t begin = first >= window ? first - window : 0;
+        std::vector<size_t> order, rank(last - begin);
+        order.reserve(last - begin);
+        for (size_t i = begin; i < last; i++)
+            if (!std::isnan(y[i]))
+                order.push_back(i);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                  { return y[a] < y[b]; });
+        const size_t n = order.size();
+        for (size_t r = 0; r < n; r++)
+            rank[order[r] - begin] = r;
+
+        size_t top = 1;
+        while (top * 2 <= n)
+            top *= 2;
+
+        std::vector<int> tree(n + 1, 0);
+        long count = 0;
+        auto update = [&](size_t i, int delta)
+        {
+            if (std::isnan(y[i]))
+                return;
+            count += delta;
+            for (size_t k = rank[i - begin] + 1; k <= n; k += k & (~k + 1))
+                tree[k] += delta;
+        };
+        auto select = [&](size_t k)
+        {
+            size_t pos = 0;
+            for (size_t step = top; step > 0; step /= 2)
+            {
+                if (pos + step <= n && static_cast<size_t>(tree[pos + step]) <= k)
+                {
+                    pos += step;
+                    k -= tree[pos];
+                }
+            }
+            return y[order[pos]];
+        };
+        auto quantile = [&](double q)
+        {
+            const double position = q * (count - 1);
+            const size_t k = static_cast<size_t>(position);
+            const double low = select(k);
+            return k + 1 < static_cast<size_t>(count) ? low + (position - k) * (select(k + 1) - low) : low;
+        };
+
+        for (size_t i = begin; i < first; i++)
+            update(i, 1);
+        for (size_t i = first; i < last; i++)
+        {
+            update(i, 1);
+            if (i >= window)
+                update(i - window, -1);
+            if (count == 0)
+            {
+                center[i] = lb[i] = ub[i] = NAN;
+                continue;
+            }
+            center[i] = quantile(0.5);
+            lb[i] = quantile(lower);
+            ub[i] = quantile(upper);
+        } });
+}
+
+CPPPLOTLIB_INLINE size_t Plotter::_chunk_count(const size_t n, const size_t min_chunk)
+{
+    return std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), n / min_chunk);
+}
+
+CPPPLOTLIB_INLINE void Plotter::_run_chunks(const size_t n, const size_t n_chunks, void (*run)(void *, size_t, size_t), void *context)
+{
+    if (n_chunks <= 1)
+    {
+        run(context, 0, n);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t k = 0; k < n_chunks; k++)
+        threads.emplace_back(run, context, n * k / n_chunks, n * (k + 1) / n_chunks);
+    for (auto &thread : threads)
+        thread.join();
+}
+
+CPPPLOTLIB_INLINE void Plotter::_fft(double *data, const size_t n, const bool inverse)
+{
+    // std::complex<double> is laid out as two doubles, real part first
+    std::complex<double> *a = reinterpret_cast<std::complex<double> *>(data);
+    for (size_t i = 1, j = 0; i < n; i++)
+    {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(a[i], a[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1)
+    {
+        const double angle = 2 * M_PI / len * (inverse ? 1 : -1);
+        const std::complex<double> step(std::cos(angle), std::sin(angle));
+        for (size_t i = 0; i < n; i += len)
+        {
+            std::complex<double> w(1.0);
+            for (size_t k = 0; k < len / 2; k++)
+            {
+                const std::complex<double> u = a[i + k], v = a[i + k + len / 2] * w;
+                a[i + k] = u + v;
+                a[i + k + len / 2] = u - v;
+                w *= step;
+            }
+        }
+    }
+}
+
+CPPPLOTLIB_INLINE void Plotter::_kde_values(const std::vector<double> &values, double bandwidth, const size_t m, std::vector<double> &grid, std::vector<double> &density)
+{
+    grid.clear();
+    density.clear();
+    const size_t n = values.size();
+    if (n == 0)
+        return;
+
+    double sum = 0.0, sum2 = 0.0, min = values[0], max = values[0];
+    for (double value : values)
+    {
+        sum += value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+    const double mean = sum / n;
+    for (double value : values)
+        sum2 += (value - mean) * (value - mean);
+    if (bandwidth <= 0.0)
+    {
+        const double sd = n > 1 ? std::sqrt(sum2 / (n - 1)) : 0.0;
+        std::vector<double> sorted = values;
+        std::nth_element(sorted.begin(), sorted.begin() + n / 4, sorted.end());
+        const double q1 = sorted[n / 4];
+        std::nth_element(sorted.begin(), sorted.begin() + 3 * n / 4, sorted.end());
+        const double iqr = sorted[3 * n / 4] - q1;
+        const double spread = iqr > 0.0 ? std::min(sd, iqr / 1.34) : sd;
+        bandwidth = 0.9 * spread * std::pow(static_cast<double>(n), -0.2);
+        if (!(bandwidth > 0.0))
+            bandwidth = std::max(std::abs(mean) * 1e-3, 1e-3);
+    }
+
+    const double lo = min - 3 * bandwidth, hi = max + 3 * bandwidth;
+    const double dx = (hi - lo) / (m - 1);
+    std::vector<double> bins(m, 0.0);
+    for (double value : values)
+    {
+        const double position = (value - lo) / dx;
+        const size_t i = std::min(static_cast<size_t>(position), m - 2);
+        const double t = position - i;
+        bins[i] += 1.0 - t;
+        bins[i + 1] += t;
+    }
+
+    size_t size = 1;
+    while (size < 2 * m)
+        size <<= 1;
+    std::vector<std::complex<double>> signal(size), kernel(size);
+    for (size_t i = 0; i < m; i++)
+        signal[i] = bins[i];
+    const double norm = 1.0 / (n * bandwidth * std::sqrt(2 * M_PI));
+    for (size_t j = 0; j < m; j++)
+    {
+        const double u = j * dx / bandwidth;
+        kernel[j] = norm * std::exp(-0.5 * u * u);
+        if (j > 0)
+            kernel[size - j] = kernel[j];
+    }
+    _fft(reinterpret_cast<double *>(signal.data()), size, false);
+    _fft(reinterpret_cast<double *>(kernel.data()), size, false);
+    for (size_t i = 0; i < size; i++)
+        signal[i] *= kernel[i];
+    _fft(reinterpret_cast<double *>(signal.data()), size, true);
+
+    grid.resize(m);
+    density.resize(m);
+    for (size_t i = 0; i < m; i++)
+    {
+        grid[i] = lo + i * dx;
+        density[i] = std::max(0.0, signal[i].real() / size);
+    }
+}
+
+CPPPLOTLIB_INLINE void Plotter::_color_series(const std::string &filename, const bool variable_size, const bool line, const char *point_type, const double size, const char *title)
+{
+    if (line)
+        fprintf(gnuplotPipe, "\"%s\" binary format='%%float64%%float64%%float64' using 1:2:3 with lines linewidth %f linecolor palette title '%s'", filename.c_str(), size, title);
+    else if (variable_size)
+        fprintf(gnuplotPipe, "\"%s\" binary format='%%float64%%float64%%float64%%float64' using 1:2:($4*%f):3 with points pointtype '%s' pointsize variable linecolor palette title '%s'", filename.c_str(), size, point_type, title);
+    else
+        fprintf(gnuplotPipe, "\"%s\" binary format='%%float64%%float64%%float64' using 1:2:3 with points pointtype '%s' pointsize %f linecolor palette title '%s'", filename.c_str(), point_type, size, title);
+}
+
+CPPPLOTLIB_INLINE int Plotter::_tick_stride(const char axis, const size_t n, const size_t label_chars, const int max_ticks) const
+{
+    double label_px = axis == 'x' ? (label_chars + 2) * 0.6 * font_size : 1.5 * font_size;
+    double axis_px = 0.8 * (axis == 'x' ? plot_width : plot_height);
+    size_t fit = std::max<size_t>(1, static_cast<size_t>(axis_px / std::max(1.0, label_px)));
+    if (max_ticks > 0)
+        fit = std::min<size_t>(fit, max_ticks);
+    return static_cast<int>((n + fit - 1) / fit);
+}
+
+CPPPLOTLIB_INLINE bool Plotter::_write_bundle(FILE *fout, const long begin, const int first_file)
+{
+    fflush(gnuplotPipe);
+    std::string commands(ftell(gnuplotPipe) - begin, '\0');
+    if (pread(fileno(gnuplotPipe), &commands[0], commands.size(), begin) != static_cast<ssize_t>(commands.size()))
+        return false;
+
+    std::vector<std::pair<std::string, std::string>> payloads;
+    for (int i = first_file; i < cnt_files; i++)
+    {
+        std::string name = std::to_string(i) + ".dat";
+        std::ifstream fin(name, std::ios::binary);
+        if (fin)
+            payloads.emplace_back(name, std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>()));
+    }
+
+    fwrite(bundle_magic, 1, 8, fout);
+    _write_blob(fout, commands.data(), commands.size());
+    uint64_t n_files = payloads.size();
+    fwrite(&n_files, sizeof(n_files), 1, fout);
+    for (const auto &payload : payloads)
+    {
+        _write_blob(fout, payload.first.data(), payload.first.size());
+        _write_blob(fout, payload.second.data(), payload.second.size());
+    }
+    return true;
+}
+
+CPPPLOTLIB_INLINE std::string Plotter::_read_blob(const std::string &bundle, size_t &offset)
+{
+    uint64_t size = 0;
+    if (offset + sizeof(size) > bundle.size())
+        throw std::runtime_error("ERROR: Truncated plot bundle!");
+    memcpy(&size, bundle.data() + offset, sizeof(size));
+    offset += sizeof(size);
+    if (size > bundle.size() - offset)
+        throw std::runtime_error("ERROR: Truncated plot bundle!");
+    offset += size;
+    return bundle.substr(offset - size, size);
+}
+
+CPPPLOTLIB_INLINE std::string Plotter::_stage_bundle(const std::string &bundle, std::string &dir, std::vector<std::string> &staged)
+{
+    if (bundle.compare(0, 8, bundle_magic, 8) != 0)
+        throw std::runtime_error("ERROR: Not a plot bundle!");
+
+    size_t offset = 8;
+    std::string commands = _read_blob(bundle, offset);
+    uint64_t n_files = 0;
+    if (offset + sizeof(n_files) > bundle.size())
+        throw std::runtime_error("ERROR: Truncated plot bundle!");
+    memcpy(&n_files, bundle.data() + offset, sizeof(n_files));
+    offset += sizeof(n_files);
+
+    const bool created = dir.empty();
+    if (created)
+    {
+        char dir_template[] = "/tmp/cppplotlib_XXXXXX";
+        if (!mkdtemp(dir_template))
+            throw std::runtime_error("ERROR: Could not create a staging directory for the plot bundle!");
+        dir = dir_template;
+    }
+
+    const size_t first_staged = staged.size();
+    try
+    {
+        for (uint64_t f = 0; f < n_files; f++)
+        {
+            std::string name = _read_blob(bundle, offset);
+            std::string payload = _read_blob(bundle, offset);
+            if (name.empty() || name.find('/') != std::string::npos)
+                throw std::runtime_error("ERROR: Invalid data file name in plot bundle!");
+
+            std::string path = dir + "/" + name;
+            std::ofstream fout(path, std::ios::binary);
+            fout.write(payload.data(), payload.size());
+            staged.push_back(path);
+            if (!fout)
+                throw std::runtime_error("ERROR: Could not stage " + path + "!");
+
+            for (const char quote : {'"', '\''})
+            {
+                const std::string from = quote + name + quote, to = quote + path + quote;
+                for (size_t pos = commands.find(from); pos != std::string::npos; pos = commands.find(from, pos + to.size()))
+                    commands.replace(pos, from.size(), to);
+            }
+        }
+    }
+    catch (...)
+    {
+        // A malformed bundle leaves nothing behind; a reused directory belongs to the caller, which cleans up its earlier files
+        if (created)
+        {
+            _remove_staged(std::vector<std::string>(staged.begin() + first_staged, staged.end()), dir);
+            staged.resize(first_staged);
+            dir.clear();
+        }
+        throw;
+    }
+    return commands;
+}
+
+CPPPLOTLIB_INLINE void Plotter::_remove_staged(const std::vector<std::string> &staged, const std::string &dir)
+{
+    for (const std::string &path : staged)
+        unlink(path.c_str());
+    if (!dir.empty())
+        rmdir(dir.c_str());
+}
+
+CPPPLOTLIB_INLINE bool Plotter::_set_timeout(const int socket_fd, const int timeout_ms)
+{
+    const timeval timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    return setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0 &&
+           setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0;
+}
+
+CPPPLOTLIB_INLINE bool Plotter::_send_full(const int socket_fd, const void *data, size_t size)
+{
+    const char *p = static_cast<const char *>(data);
+    while (size > 0)
+    {
+        ssize_t n = send(socket_fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+CPPPLOTLIB_INLINE bool Plotter::_recv_full(const int socket_fd, void *data, size_t size)
+{
+    char *p = static_cast<char *>(data);
+    while (size > 0)
+    {
+        ssize_t n = recv(socket_fd, p, size, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+CPPPLOTLIB_INLINE bool Plotter::_send_message(const int socket_fd, const uint64_t kind, const int fd)
+{
+    char header[16];
+    memcpy(header, daemon_magic, 8);
+    memcpy(header + 8, &kind, sizeof(kind));
+    iovec iov = {header, sizeof(header)};
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    if (fd >= 0)
+    {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    ssize_t n;
+    do
+        n = sendmsg(socket_fd, &msg, MSG_NOSIGNAL);
+    while (n < 0 && errno == EINTR);
+    return n == static_cast<ssize_t>(sizeof(header));
+}
+
+CPPPLOTLIB_INLINE bool Plotter::_read_reply(const int socket_fd, std::string &messages)
+{
+    uint64_t header[2];
+    if (!_recv_full(socket_fd, header, sizeof(header)) || header[1] > (1u << 24))
+        return false;
+    std::string text(header[1], '\0');
+    if (!_recv_full(socket_fd, &text[0], text.size()))
+        return false;
+    messages += text;
+    return header[0] == 0;
+}
+
+CPPPLOTLIB_INLINE void Plotter::_daemon_submit(const bool finish)
+{
+    fflush(gnuplotPipe);
+    const long end = ftell(gnuplotPipe);
+
+    if (daemon_fd < 0 && !daemon_failed && !debug)
+    {
+        const std::string path = daemonSocket();
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        int fd = path.size() < sizeof(addr.sun_path) ? socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0) : -1;
+        if (fd >= 0)
+        {
+            memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+            // The daemon runs the commands, and writes the outputs, as its own user; anyone else listening there is not trusted
+            ucred cred;
+            socklen_t len = sizeof(cred);
+            char greeting[16];
+            uint64_t reply_ms = 0;
+            if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0 &&
+                getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == getuid() &&
+                _set_timeout(fd, daemon_greeting_ms) && _recv_full(fd, greeting, sizeof(greeting)) &&
+                memcmp(greeting, daemon_magic, 8) == 0)
+                memcpy(&reply_ms, greeting + 8, sizeof(reply_ms));
+            // The daemon gives up on a job, and replies, within the time it announced; the client waits a little longer, then renders locally
+            if (reply_ms > 0 && reply_ms < (1u << 30) && _set_timeout(fd, static_cast<int>(reply_ms) + daemon_greeting_ms))
+                daemon_fd = fd;
+            else
+                close(fd);
+        }
+        if (daemon_fd < 0)
+        {
+            std::cerr << "Could not reach the render daemon at " << path << "; rendering with a local gnuplot" << std::endl;
+            daemon_failed = true;
+        }
+    }
+    if (daemon_fd < 0)
+    {
+        _native_forward();
+        return;
+    }
+
+    std::string messages;
+    bool ok = true;
+    if (end > sent_pos || cnt_files > daemon_files)
+    {
+#ifdef __linux__
+        int fd = memfd_create("cppplotlib_job", MFD_CLOEXEC);
+        FILE *job = fd >= 0 ? fdopen(fd, "w+b") : tmpfile();
+#else
+        FILE *job = tmpfile();
+#endif
+        ok = job && _write_bundle(job, sent_pos, daemon_files) && fflush(job) == 0 &&
+             _send_message(daemon_fd, daemon_job, fileno(job)) && _read_reply(daemon_fd, messages);
+        if (job)
+            fclose(job);
+        if (ok)
+        {
+            sent_pos = end;
+            daemon_files = cnt_files;
+        }
+    }
+    if (ok && finish)
+        ok = _send_message(daemon_fd, daemon_close, -1) && _read_reply(daemon_fd, messages);
+
+    if (!messages.empty())
+        std::cerr << messages;
+    if (!ok || finish)
+    {
+        close(daemon_fd);
+        daemon_fd = -1;
+    }
+    if (!ok)
+    {
+        // Replays everything on a local gnuplot, from the terminal settings on; the data files are still in the working directory
+        std::cerr << "Lost the render daemon; rendering with a local gnuplot" << std::endl;
+        daemon_failed = true;
+        sent_pos = 0;
+        _native_forward();
+    }
+}
+
+CPPPLOTLIB_INLINE void Plotter::_write_terminal()
+{
+    switch (output_terminal)
+    {
+    case PNGCAIRO:
+        fprintf(gnuplotPipe, "set terminal pngcairo enhanced font ',%d' size %d, %d\n", font_size, plot_width, plot_height);
+        break;
+    case PNG:
+        fprintf(gnuplotPipe, "set terminal png truecolor enhanced font ',%d' size %d, %d\n", font_size, plot_width, plot_height);
+        break;
+    case SVG:
+        fprintf(gnuplotPipe, "set terminal svg enhanced font ',%d' size %d, %d\n", font_size, plot_width, plot_height);
+        break;
+    case PDFCAIRO:
+        fprintf(gnuplotPipe, "set terminal pdfcairo enhanced font ',%d' size %fin, %fin\n", font_size, plot_width / 72.0, plot_height / 72.0);
+        break;
+    case DRAFT:
+        fprintf(gnuplotPipe, "set terminal png noenhanced font ',%d' size %d, %d\n", font_size, plot_width, plot_height);
+        break;
+    }
+}
+
+CPPPLOTLIB_INLINE void Plotter::_native_add(const std::string &filename, std::vector<double> &&x, std::vector<double> &&y, const char *title, const char *color, const bool new_figure, const bool set_range)
+{
+    if (new_figure)
+    {
+        native->series.clear();
+        figure_pos = ftell(gnuplotPipe);
+        figure_set_range = set_range;
+    }
+    else if (figure_pos < 0)
+        native_ok = false;
+
+    if (set_range)
+    {
+        double x0 = INFINITY, x1 = -INFINITY, y0 = INFINITY, y1 = -INFINITY;
+        for (size_t i = 0; i < x.size(); i++)
+            if (std::isfinite(x[i]) && std::isfinite(y[i]))
+            {
+                x0 = std::min(x0, x[i]), x1 = std::max(x1, x[i]);
+                y0 = std::min(y0, y[i]), y1 = std::max(y1, y[i]);
+            }
+        if (x0 <= x1 && y0 <= y1)
+        {
+            native->has_xlim = native->has_ylim = true;
+            native->xmin = x0 - (x1 - x0) * 0.05;
+            native->xmax = x1 + (x1 - x0) * 0.05;
+            native->ymin = y0 - (y1 - y0) * 0.05;
+            native->ymax = y1 + (y1 - y0) * 0.05;
+        }
+    }
+
+    native->series.emplace_back();
+    NativeRenderer::Series &series = native->series.back();
+    series.filename = filename;
+    series.title = title;
+    series.x = std::move(x);
+    series.y = std::move(y);
+    if (std::string(color) != "auto")
+    {
+        series.auto_color = false;
+        if (!NativeRenderer::parseColor(color, series.color))
+            native_ok = false;
+    }
+}
+
+CPPPLOTLIB_INLINE void Plotter::_native_line(const std::string &filename, std::vector<double> &&x, std::vector<double> &&y, const char *line_title, const char *line_color, const MarkerStyle marker, const double point_size, const double line_width, const LineStyle line_style, const bool new_figure, const bool set_range)
+{
+    _native_add(filename, std::move(x), std::move(y), line_title, line_color, new_figure, set_range);
+    NativeRenderer::Series &series = native->series.back();
+    series.kind = NativeRenderer::LINE;
+    series.point_size = point_size;
+    series.line_width = line_width;
+    switch (marker)
+    {
+    case None:
+        break;
+    case Plus:
+        series.marker = NativeRenderer::PLUS;
+        break;
+    case Cross:
+        series.marker = NativeRenderer::CROSS;
+        break;
+    case Box:
+        series.marker = NativeRenderer::BOX;
+        break;
+    case BoxF:
+        series.marker = NativeRenderer::BOX_F;
+        break;
+    case Circle:
+        series.marker = NativeRenderer::CIRCLE;
+        break;
+    case CircleF:
+        series.marker = NativeRenderer::CIRCLE_F;
+        break;
+    default:
+        native_ok = false;
+    }
+    if (line_style != SOLID)
+        native_ok = false;
+}
+
+CPPPLOTLIB_INLINE void Plotter::_native_scatter(const std::string &filename, std::vector<double> &&x, std::vector<double> &&y, const char *point_type, const double point_size, const char *title, const char *point_color, const bool new_figure, const bool set_range)
+{
+    _native_add(filename, std::move(x), std::move(y), title, point_color, new_figure, set_range);
+    NativeRenderer::Series &series = native->series.back();
+    series.kind = NativeRenderer::SCATTER;
+    series.marker = NativeRenderer::GLYPH;
+    series.glyph = point_type[0];
+    series.point_size = point_size;
+    if (std::string(point_type).size() != 1)
+        native_ok = false;
+}
+
+CPPPLOTLIB_INLINE void Plotter::_native_fill(const std::string &filename, std::vector<double> &&x, std::vector<double> &&ub, std::vector<double> &&lb, const char *color, const double alpha)
+{
+    _native_add(filename, std::move(x), std::move(ub), "", color, false, false);
+    NativeRenderer::Series &series = native->series.back();
+    series.kind = NativeRenderer::FILL;
+    series.y2 = std::move(lb);
+    series.alpha = alpha;
+}
+
+CPPPLOTLIB_INLINE void Plotter::_open_buffer_fifo()
+{
+    if (buffer_fd >= 0)
+        return;
+
+    char dir[] = "/tmp/cppplotlib_XXXXXX";
+    if (!mkdtemp(dir))
+        throw std::runtime_error("ERROR: Could not create a directory for the buffer FIFO!");
+    std::string path = std::string(dir) + "/output.png";
+    if (mkfifo(path.c_str(), 0600) != 0)
+    {
+        rmdir(dir);
+        throw std::runtime_error("ERROR: Could not create the buffer FIFO!");
+    }
+    buffer_fd = open(path.c_str(), O_RDWR | O_NONBLOCK);
+    if (buffer_fd < 0)
+    {
+        unlink(path.c_str());
+        rmdir(dir);
+        throw std::runtime_error("ERROR: Could not open the buffer FIFO!");
+    }
+    buffer_fifo = path;
+}
+
+CPPPLOTLIB_INLINE void Plotter::_read_png(std::vector<std::byte> &buffer, const int timeout_ms)
+{
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    buffer.clear();
+    size_t chunk = 8;
+    while (true)
+    {
+        // Skip whole chunks while they are complete; the image ends after the IEND chunk
+        while (buffer.size() >= chunk + 8)
+        {
+            if (chunk == 8 && memcmp(buffer.data(), signature, 8) != 0)
+                throw std::runtime_error("ERROR: gnuplot did not write a PNG image to the buffer!");
+            const unsigned char *header = reinterpret_cast<const unsigned char *>(buffer.data()) + chunk;
+            const size_t length = (size_t(header[0]) << 24) | (size_t(header[1]) << 16) | (size_t(header[2]) << 8) | size_t(header[3]);
+            if (buffer.size() < chunk + 12 + length)
+                break;
+            chunk += 12 + length;
+            if (memcmp(header + 4, "IEND", 4) == 0)
+            {
+                buffer.resize(chunk);
+                return;
+            }
+        }
+
+        pollfd fd = {buffer_fd, POLLIN, 0};
+        if (poll(&fd, 1, timeout_ms) <= 0)
+            throw std::runtime_error("ERROR: Timed out waiting for gnuplot to render into the buffer!");
+        const size_t size = buffer.size();
+        buffer.resize(size + (1 << 16));
+        ssize_t n = read(buffer_fd, buffer.data() + size, 1 << 16);
+        buffer.resize(size + std::max<ssize_t>(n, 0));
+    }
+}
+
+CPPPLOTLIB_INLINE void Plotter::_native_forward()
+{
+    if (!gnuplotProcess)
+    {
+        if (debug)
+            gnuplotProcess = fopen("debug_plotter.txt", "w");
+        else
+            gnuplotProcess = popen("gnuplot -persistent", "w");
+        if (!gnuplotProcess)
+        {
+            std::cerr << "Could not set up pipe with gnuplot" << std::endl;
+            return;
+        }
+    }
+
+    fflush(gnuplotPipe);
+    long end = ftell(gnuplotPipe);
+    char buffer[1 << 16];
+    while (sent_pos < end)
+    {
+        ssize_t n = pread(fileno(gnuplotPipe), buffer, std::min<long>(sizeof(buffer), end - sent_pos), sent_pos);
+        if (n <= 0)
+            break;
+        fwrite(buffer, 1, n, gnuplotProcess);
+        sent_pos += n;
+    }
+    fflush(gnuplotProcess);
+}
+
+CPPPLOTLIB_INLINE bool Plotter::_native_insert(const long pos, const std::string &command)
+{
+    fflush(gnuplotPipe);
+    long end = ftell(gnuplotPipe);
+    if (pos < sent_pos || pos > end)
+        return false;
+    std::string tail(end - pos, '\0');
+    if (pread(fileno(gnuplotPipe), &tail[0], tail.size(), pos) != static_cast<ssize_t>(tail.size()) || ftruncate(fileno(gnuplotPipe), pos) != 0)
+        return false;
+    fseek(gnuplotPipe, pos, SEEK_SET);
+    fputs(command.c_str(), gnuplotPipe);
+    fwrite(tail.data(), 1, tail.size(), gnuplotPipe);
+    return true;
+}
+
+CPPPLOTLIB_INLINE void Plotter::_native_plot(std::vector<std::byte> *buffer, const int timeout_ms)
+{
+    _native_begin();
+    if (native_ok && figure_pos >= 0 && (buffer || !native_output.empty()) && output_terminal != SVG && output_terminal != PDFCAIRO)
+    {
+        if (buffer)
+        {
+            std::vector<uint8_t> png;
+            NativeRenderer::encodePNG(native->render().data(), native->width, native->height, png);
+            buffer->resize(png.size());
+            memcpy(buffer->data(), png.data(), png.size());
+        }
+        else if (!native->save(native_output.c_str()))
+            std::cerr << "Could not write " << native_output << std::endl;
+
+        // gnuplot never needs the plot command of a natively rendered figure, only the ranges it leaves behind
+        fflush(gnuplotPipe);
+        if (ftruncate(fileno(gnuplotPipe), figure_pos) != 0)
+            std::cerr << "Could not truncate the buffered gnuplot commands" << std::endl;
+        fseek(gnuplotPipe, figure_pos, SEEK_SET);
+        if (figure_set_range)
+            fprintf(gnuplotPipe, "set xrange [%f:%f]\nset yrange [%f:%f]\n", native->xmin, native->xmax, native->ymin, native->ymax);
+    }
+    else
+    {
+        // The series hold the values as doubles, so they are written with enough digits to read back the same
+        const int digits = std::numeric_limits<double>::max_digits10;
+        for (const NativeRenderer::Series &series : native->series)
+        {
+            if (series.kind == NativeRenderer::FILL)
+                _write_data(series.filename, series.x, series.y, series.y2, digits);
+            else
+                _write_data(series.filename, series.x, series.y, 0.0, digits);
+        }
+
+        // Route the figure to the buffer FIFO by inserting `set output` where the figure starts; without a known start, it is replotted
+        bool routed = false;
+        if (buffer)
+        {
+            _open_buffer_fifo();
+            routed = figure_pos >= 0 && _native_insert(figure_pos, "set output '" + buffer_fifo + "'\n");
+        }
+        // Otherwise gnuplot is sent the save path ahead of the figure; a path it was never sent may hold a natively rendered figure it must not truncate
+        else if (gnuplot_output != native_output && _native_insert(sent_pos, native_output.empty() ? "set output\n" : "set output '" + native_output + "'\n"))
+            gnuplot_output = native_output;
+        fprintf(gnuplotPipe, "\n");
+        if (buffer && !routed)
+            fprintf(gnuplotPipe, "set output '%s'\nreplot\n", buffer_fifo.c_str());
+        _cleanup_plot();
+        if (buffer)
+        {
+            fprintf(gnuplotPipe, "set output\n");
+            gnuplot_output.clear();
+        }
+        _native_forward();
+        if (buffer && !debug && gnuplotProcess)
+            _read_png(*buffer, timeout_ms);
+    }
+
+    native->series.clear();
+    plot_cleanup.clear();
+    figure_pos = -1;
+    _native_end();
+}
+
+CPPPLOTLIB_INLINE void Plotter::_native_reset()
+{
+    native->reset();
+    native_ok = true;
+    figure_pos = -1;
+
+    fflush(gnuplotPipe);
+    if (ftruncate(fileno(gnuplotPipe), sent_pos) != 0)
+        std::cerr << "Could not truncate the buffered gnuplot commands" << std::endl;
+    fseek(gnuplotPipe, sent_pos, SEEK_SET);
+}
+
+#endif
+
+#define CPPPLOTLIB_TEMPLATES_Y(PREFIX, T2)                                                                                                                                                                        \
+    PREFIX template void Plotter::createPlot<T2>(const std::vector<T2> &, const char *, const char *, const MarkerStyle, const double, const double, const LineStyle, const bool);                                 \
+    PREFIX template void Plotter::addPlot<T2>(const std::vector<T2> &, const char *, const char *, const MarkerStyle, const double, const double, const LineStyle);                                                \
+    PREFIX template void Plotter::createScatterPlot<T2>(const std::vector<T2> &, const char *, const double, const char *, const char *, const bool);                                                              \
+    PREFIX template void Plotter::addScatterPlot<T2>(const std::vector<T2> &, const char *, const double, const char *, const char *);                                                                              \
+    PREFIX template void Plotter::fillBetween<T2>(const std::vector<T2> &, const std::vector<T2> &, const char *, const double);
+
+#define CPPPLOTLIB_TEMPLATES_XY(PREFIX, T1, T2)                                                                                                                                                                   \
+    PREFIX template void Plotter::createPlot<T1, T2>(const std::vector<T1> &, const std::vector<T2> &, const char *, const char *, const MarkerStyle, const double, const double, const LineStyle, const T1, const bool); \
+    PREFIX template void Plotter::addPlot<T1, T2>(const std::vector<T1> &, const std::vector<T2> &, const char *, const char *, const MarkerStyle, const double, const double, const LineStyle, const T1);          \
+    PREFIX template void Plotter::createScatterPlot<T1, T2>(const std::vector<T1> &, const std::vector<T2> &, const char *, const double, const char *, const char *, const bool);                                 \
+    PREFIX template void Plotter::addScatterPlot<T1, T2>(const std::vector<T1> &, const std::vector<T2> &, const char *, const double, const char *, const char *);                                                 \
+    PREFIX template void Plotter::fillBetween<T1, T2>(const std::vector<T1> &, const std::vector<T2> &, const std::vector<T2> &, const char *, const double);
+
+#define CPPPLOTLIB_TEMPLATES_X(PREFIX, T1)       \
+    CPPPLOTLIB_TEMPLATES_Y(PREFIX, T1)           \
+    CPPPLOTLIB_TEMPLATES_XY(PREFIX, T1, int)     \
+    CPPPLOTLIB_TEMPLATES_XY(PREFIX, T1, float)   \
+    CPPPLOTLIB_TEMPLATES_XY(PREFIX, T1, double)  \
+    CPPPLOTLIB_TEMPLATES_XY(PREFIX, T1, int64_t)
+
+#define CPPPLOTLIB_TEMPLATES(PREFIX)           \
+    CPPPLOTLIB_TEMPLATES_X(PREFIX, int)        \
+    CPPPLOTLIB_TEMPLATES_X(PREFIX, float)      \
+    CPPPLOTLIB_TEMPLATES_X(PREFIX, double)     \
+    CPPPLOTLIB_TEMPLATES_X(PREFIX, int64_t)
+
+#if defined(CPPPLOTLIB_COMPILED) && !defined(CPPPLOTLIB_IMPLEMENTATION)
+CPPPLOTLIB_TEMPLATES(extern)
+#endif
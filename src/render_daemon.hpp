@@ -0,0 +1,500 @@
+// ****************************
+// * Author: Abhinav Barnwal
+// * URL: https://github.com/barnawalabhinav/cppplotlib
+// * This code is a part of the project "cppplotlib" which is a simple C++ wrapper for gnuplot.
+// * The project is licensed under MIT License.
+// ****************************
+
+#pragma once
+
+#include <condition_variable>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "plotter.hpp"
+
+extern char **environ;
+
+/**
+ * @brief Renders the figures of Plotter(..., Plotter::DAEMON) clients on a pool of gnuplot processes that are started, and warmed up, once
+ * @note 1. Clients connect to a Unix domain socket; each plot() arrives as a plot bundle in a memory file whose descriptor is passed over the socket
+ * @note 2. A client holds one worker from its first plot() until its Plotter is destroyed; the worker is then reset for the next client. A client that finds every worker held for `wait_ms` is turned away and renders locally
+ * @note 3. gnuplot can run shell commands, so the socket is only open to the user running the daemon
+ * @note 4. Linux only; needs gnuplot 5.2 or later (`printerr`, `reset session`); see plotterd.cpp for the daemon program
+ */
+class RenderDaemon
+{
+private:
+    struct Worker
+    {
+        pid_t pid = -1;
+        FILE *in = nullptr;
+        int err_fd = -1;
+        bool busy = false;
+        unsigned long syncs = 0;
+    };
+
+    std::string socket_path;
+    int listen_fd = -1;
+    int timeout_ms;
+    int wait_ms;
+    std::vector<Worker> workers;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::set<int> client_fds;
+    int active_clients = 0;
+    bool stopping = false;
+
+    /**
+     * @brief Starts a gnuplot process with pipes to its stdin and stderr, and lets it load its fonts
+     */
+    inline bool _spawn(Worker &worker)
+    {
+        int in[2], err[2];
+        if (pipe2(in, O_CLOEXEC) != 0)
+            return false;
+        if (pipe2(err, O_CLOEXEC) != 0)
+        {
+            close(in[0]);
+            close(in[1]);
+            return false;
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, in[0], STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, err[1], STDERR_FILENO);
+        char *argv[] = {const_cast<char *>("gnuplot"), nullptr};
+        int rc = posix_spawnp(&worker.pid, "gnuplot", &actions, nullptr, argv, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(in[0]);
+        close(err[1]);
+        if (rc != 0)
+        {
+            close(in[1]);
+            close(err[0]);
+            worker.pid = -1;
+            return false;
+        }
+
+        worker.in = fdopen(in[1], "w");
+        worker.err_fd = err[0];
+        // The first cairo plot of a process loads the fonts, which is most of gnuplot's start-up cost
+        fprintf(worker.in, "set terminal pngcairo\nset output '/dev/null'\nplot 0\nset output\nreset session\n");
+        std::string messages;
+        return _sync(worker, messages);
+    }
+
+    /**
+     * @brief Stops a gnuplot process; it exits at the end of its input, or is killed after `timeout_ms`
+     */
+    inline void _terminate(Worker &worker)
+    {
+        if (worker.in)
+            fclose(worker.in);
+        if (worker.err_fd >= 0)
+            close(worker.err_fd);
+        for (int waited = 0; worker.pid > 0 && waitpid(worker.pid, nullptr, WNOHANG) == 0; waited += 10)
+        {
+            if (waited >= timeout_ms)
+            {
+                kill(worker.pid, SIGKILL);
+                waitpid(worker.pid, nullptr, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        worker.in = nullptr;
+        worker.err_fd = -1;
+        worker.pid = -1;
+    }
+
+    /**
+     * @brief Waits until the worker has run everything sent so far
+     * @param messages: receives what gnuplot printed meanwhile, e.g. warnings and errors
+     * @return false if gnuplot exited or did not finish within `timeout_ms`
+     */
+    inline bool _sync(Worker &worker, std::string &messages)
+    {
+        if (!worker.in)
+            return false;
+        const std::string token = "cppplotlib_sync_" + std::to_string(++worker.syncs);
+        fprintf(worker.in, "\nprinterr '%s'\n", token.c_str());
+        if (fflush(worker.in) != 0)
+            return false;
+
+        std::string text;
+        char buffer[4096];
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (true)
+        {
+            size_t pos = text.find(token + "\n");
+            if (pos != std::string::npos && (pos == 0 || text[pos - 1] == '\n'))
+            {
+                messages += text.substr(0, pos);
+                return true;
+            }
+
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            pollfd pfd = {worker.err_fd, POLLIN, 0};
+            if (left <= 0 || poll(&pfd, 1, static_cast<int>(left)) <= 0)
+            {
+                if (left > 0 && errno == EINTR)
+                    continue;
+                messages += text;
+                return false;
+            }
+            ssize_t n = read(worker.err_fd, buffer, sizeof(buffer));
+            if (n <= 0)
+            {
+                messages += text;
+                return false;
+            }
+            text.append(buffer, n);
+        }
+    }
+
+    /**
+     * @brief Replaces a worker that exited or hung
+     */
+    inline void _restart(Worker &worker)
+    {
+        if (worker.pid > 0)
+            kill(worker.pid, SIGKILL);
+        _terminate(worker);
+        if (!_spawn(worker))
+            std::cerr << "Could not restart gnuplot" << std::endl;
+    }
+
+    /**
+     * @brief Waits up to `wait_ms` for an idle worker and marks it busy
+     * @return nullptr if the daemon is stopping or every worker stayed busy
+     */
+    inline Worker *_acquire()
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait_ms);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            if (stopping)
+                return nullptr;
+            for (Worker &worker : workers)
+                if (!worker.busy)
+                {
+                    worker.busy = true;
+                    return &worker;
+                }
+            if (cv.wait_until(lock, deadline) == std::cv_status::timeout)
+                return nullptr;
+        }
+    }
+
+    /**
+     * @brief Resets a worker for the next client and marks it idle
+     */
+    inline void _release(Worker &worker, std::string &messages)
+    {
+        if (worker.in)
+            fprintf(worker.in, "\nunset multiplot\nunset output\nreset session\n");
+        if (!_sync(worker, messages))
+            _restart(worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        worker.busy = false;
+        cv.notify_all();
+    }
+
+    /**
+     * @brief Receives a message of a client
+     * @param kind: receives Plotter::daemon_job or Plotter::daemon_close
+     * @param fd: receives the attached file descriptor, or -1
+     * @return false if the client disconnected or sent something else
+     */
+    inline static bool _receive(const int socket_fd, uint64_t &kind, int &fd)
+    {
+        char header[16];
+        iovec iov = {header, sizeof(header)};
+        char control[CMSG_SPACE(sizeof(int))];
+        msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        fd = -1;
+        ssize_t n;
+        do
+            n = recvmsg(socket_fd, &msg, MSG_CMSG_CLOEXEC);
+        while (n < 0 && errno == EINTR);
+        for (cmsghdr *cmsg = n > 0 ? CMSG_FIRSTHDR(&msg) : nullptr; cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+                memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+
+        if (n <= 0 || !Plotter::_recv_full(socket_fd, header + n, sizeof(header) - n) || memcmp(header, Plotter::daemon_magic, 8) != 0)
+        {
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+        memcpy(&kind, header + 8, sizeof(kind));
+        return true;
+    }
+
+    /**
+     * @brief Replies to a client message with a status (0 if rendered) and the gnuplot messages
+     */
+    inline static bool _reply(const int socket_fd, const uint64_t status, const std::string &messages)
+    {
+        const uint64_t header[2] = {status, messages.size()};
+        return Plotter::_send_full(socket_fd, header, sizeof(header)) && Plotter::_send_full(socket_fd, messages.data(), messages.size());
+    }
+
+    /**
+     * @brief Tells a new client the longest a reply may take: waiting for a worker, a job that times out, and restarting its gnuplot
+     */
+    inline bool _greet(const int socket_fd) const
+    {
+        char greeting[16];
+        const uint64_t reply_ms = static_cast<uint64_t>(wait_ms) + 2 * static_cast<uint64_t>(timeout_ms);
+        memcpy(greeting, Plotter::daemon_magic, 8);
+        memcpy(greeting + 8, &reply_ms, sizeof(reply_ms));
+        return Plotter::_send_full(socket_fd, greeting, sizeof(greeting));
+    }
+
+    /**
+     * @brief Reads the whole contents of a job's memory file
+     */
+    inline static bool _read_job(const int fd, std::string &bundle)
+    {
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+            return false;
+        bundle.assign(st.st_size, '\0');
+        for (size_t done = 0; done < bundle.size();)
+        {
+            ssize_t n = pread(fd, &bundle[done], bundle.size() - done, done);
+            if (n <= 0)
+                return false;
+            done += n;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Serves the jobs of one client until it disconnects
+     */
+    inline void _serve(const int client_fd)
+    {
+        Worker *worker = nullptr;
+        std::string dir;
+        std::vector<std::string> staged;
+
+        uint64_t kind;
+        int fd;
+        const bool greeted = _greet(client_fd);
+        while (greeted && _receive(client_fd, kind, fd))
+        {
+            std::string messages;
+            bool ok = false;
+            if (kind == Plotter::daemon_job && fd >= 0)
+            {
+                std::string bundle;
+                const bool read = _read_job(fd, bundle);
+                close(fd);
+                const bool first = !worker;
+                if (!worker)
+                    worker = _acquire();
+                if (!worker)
+                {
+                    // The client replays the figure on a local gnuplot
+                    _reply(client_fd, 1, "ERROR: All gnuplot workers are busy!\n");
+                    break;
+                }
+
+                try
+                {
+                    if (!read)
+                        throw std::runtime_error("ERROR: Could not read the plot bundle!");
+                    if (!worker->in)
+                        throw std::runtime_error("ERROR: gnuplot is not running!");
+                    std::string commands = Plotter::_stage_bundle(bundle, dir, staged);
+                    // Data files of earlier jobs keep their relative names, which resolve in the staging directory
+                    if (first)
+                        fprintf(worker->in, "cd '%s'\n", dir.c_str());
+                    fwrite(commands.data(), 1, commands.size(), worker->in);
+                    ok = _sync(*worker, messages);
+                    if (!ok)
+                    {
+                        messages += "ERROR: gnuplot exited or did not finish the job!\n";
+                        _restart(*worker);
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    messages += std::string(e.what()) + "\n";
+                }
+            }
+            else if (kind == Plotter::daemon_close)
+            {
+                if (fd >= 0)
+                    close(fd);
+                if (worker)
+                    _release(*worker, messages);
+                worker = nullptr;
+                _reply(client_fd, 0, messages);
+                break;
+            }
+            else if (fd >= 0)
+                close(fd);
+
+            if (!_reply(client_fd, ok ? 0 : 1, messages))
+                break;
+        }
+
+        if (worker)
+        {
+            std::string messages;
+            _release(*worker, messages);
+        }
+        Plotter::_remove_staged(staged, dir);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        client_fds.erase(client_fd);
+        close(client_fd);
+        active_clients--;
+        cv.notify_all();
+    }
+
+public:
+    /**
+     * @brief Constructor; starts the workers and listens on the socket
+     * @param socket_path: path of the Unix domain socket; Plotter::daemonSocket() is where clients look for it
+     * @param n_workers: number of gnuplot processes, i.e. of clients rendered at the same time
+     * @param timeout_ms: time a job may take before its gnuplot is replaced and the client falls back to a local gnuplot; clients are told how long to wait for a reply from it
+     * @param wait_ms: time a new client waits for a worker before it is turned away and falls back to a local gnuplot
+     * @note  `socket_path` is not a string, it is a char array; use string.c_str() to convert a string to char array
+     */
+    inline explicit RenderDaemon(const char *socket_path, const int n_workers = 4, const int timeout_ms = 60000, const int wait_ms = 5000)
+        : socket_path(socket_path), timeout_ms(timeout_ms), wait_ms(wait_ms), workers(std::max(n_workers, 1))
+    {
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if (this->socket_path.size() >= sizeof(addr.sun_path))
+            throw std::runtime_error("ERROR: Socket path " + this->socket_path + " is too long!");
+        memcpy(addr.sun_path, socket_path, this->socket_path.size() + 1);
+        // Writing to a gnuplot that exited, or to a client that left, must fail instead of ending the process
+        signal(SIGPIPE, SIG_IGN);
+
+        // A socket left behind by a daemon that died is replaced; a live daemon is left alone
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (probe >= 0 && connect(probe, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0)
+        {
+            close(probe);
+            throw std::runtime_error("ERROR: A render daemon is already listening on " + this->socket_path + "!");
+        }
+        if (probe >= 0)
+            close(probe);
+
+        for (Worker &worker : workers)
+            if (!_spawn(worker))
+            {
+                for (Worker &started : workers)
+                    _terminate(started);
+                throw std::runtime_error("ERROR: Could not start gnuplot!");
+            }
+
+        unlink(socket_path);
+        listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        const mode_t mask = umask(0177);
+        const bool bound = listen_fd >= 0 && bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+        umask(mask);
+        if (!bound || listen(listen_fd, 64) != 0)
+        {
+            if (listen_fd >= 0)
+                close(listen_fd);
+            for (Worker &worker : workers)
+                _terminate(worker);
+            throw std::runtime_error("ERROR: Could not listen on " + this->socket_path + "!");
+        }
+    }
+
+    RenderDaemon(const RenderDaemon &) = delete;
+    RenderDaemon &operator=(const RenderDaemon &) = delete;
+
+    /**
+     * @brief Destructor; disconnects the clients, stops the workers and removes the socket
+     */
+    inline virtual ~RenderDaemon()
+    {
+        stop();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]
+                    { return active_clients == 0; });
+        }
+        close(listen_fd);
+        unlink(socket_path.c_str());
+        for (Worker &worker : workers)
+            _terminate(worker);
+    }
+
+    /**
+     * @brief Accepts clients, each served on its own thread, until stop() is called
+     */
+    inline void run()
+    {
+        while (true)
+        {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0 && errno != EINTR && errno != ECONNABORTED)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping)
+            {
+                if (fd >= 0)
+                    close(fd);
+                return;
+            }
+            if (fd < 0)
+                continue;
+
+            ucred cred;
+            socklen_t len = sizeof(cred);
+            if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 || cred.uid != getuid())
+            {
+                close(fd);
+                continue;
+            }
+
+            client_fds.insert(fd);
+            active_clients++;
+            std::thread([this, fd]
+                        { _serve(fd); })
+                .detach();
+        }
+    }
+
+    /**
+     * @brief Makes run() return and disconnects the clients, which render the rest of their figures locally; safe to call from another thread
+     */
+    inline void stop()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping)
+            return;
+        stopping = true;
+        shutdown(listen_fd, SHUT_RDWR);
+        for (int fd : client_fds)
+            shutdown(fd, SHUT_RDWR);
+        cv.notify_all();
+    }
+};
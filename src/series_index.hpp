@@ -0,0 +1,386 @@
+// ****************************
+// * Author: Abhinav Barnwal
+// * URL: https://github.com/barnawalabhinav/cppplotlib
+// * This code is a part of the project "cppplotlib" which is a simple C++ wrapper for gnuplot.
+// * The project is licensed under MIT License.
+// ****************************
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief Min/max pyramid over a series with increasing x, to render any x-window of it without scanning the whole series
+ * @note 1. Level L splits the series into buckets of fanout^L points and keeps the index of the minimum and maximum y of each bucket
+ * @note 2. query() covers a window with the coarsest buckets that still give one per pixel, and finer buckets only at its two ends; O(pixels + log n)
+ * @note 3. save() writes the series and the pyramid to one file; loading it maps the file, so a query only reads the pages it touches
+ * @note 4. The file uses the byte order of the machine that wrote it; drawn by Plotter::createPlot(const SeriesIndex &, ...)
+ */
+class SeriesIndex
+{
+private:
+    static constexpr const char *index_magic = "CPPPLOTI";
+    static const uint32_t index_version = 1;
+    static const uint64_t no_point = ~static_cast<uint64_t>(0);
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t fanout;
+        uint64_t n;
+        uint64_t has_x;
+        uint64_t n_levels;
+    };
+
+    uint64_t n = 0;
+    uint64_t fanout = 4;
+    bool has_x = false;
+
+    // Owned data, or empty when the index is mapped from a file
+    std::vector<double> x_data;
+    std::vector<double> y_data;
+    std::vector<uint64_t> extrema_data;
+    std::vector<uint64_t> offset_data;
+
+    const double *xp = nullptr;
+    const double *yp = nullptr;
+    const uint64_t *extrema = nullptr; // (argmin, argmax) per bucket, levels 1 and up back to back
+    const uint64_t *offsets = nullptr; // first bucket of each level in `extrema`; offsets[0] is level 1
+    uint64_t n_levels = 0;             // levels above the raw points
+
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+
+    inline double _x(const uint64_t i) const
+    {
+        return has_x ? xp[i] : static_cast<double>(i);
+    }
+
+    inline uint64_t _bucket_size(const uint64_t level) const
+    {
+        uint64_t size = 1;
+        for (uint64_t l = 0; l < level; l++)
+            size *= fanout;
+        return size;
+    }
+
+    /**
+     * @brief Builds the levels above the raw points
+     */
+    inline void _build()
+    {
+        if (fanout < 2 || fanout > 65536)
+            throw std::runtime_error("ERROR: SeriesIndex fanout must be between 2 and 65536!");
+
+        offset_data.assign(1, 0);
+        uint64_t prev_buckets = n, size = 1;
+        while (prev_buckets > 1)
+        {
+            size *= fanout;
+            const uint64_t buckets = (n + size - 1) / size;
+            const uint64_t prev_offset = offset_data.size() > 1 ? offset_data[offset_data.size() - 2] : 0;
+            for (uint64_t b = 0; b < buckets; b++)
+            {
+                uint64_t lo = no_point, hi = no_point;
+                const uint64_t first = b * fanout, last = std::min(prev_buckets, first + fanout);
+                for (uint64_t c = first; c < last; c++)
+                {
+                    // Level 1 reads the raw points, higher levels the extrema of the level below
+                    const uint64_t cmin = offset_data.size() == 1 ? c : extrema_data[2 * (prev_offset + c)];
+                    const uint64_t cmax = offset_data.size() == 1 ? c : extrema_data[2 * (prev_offset + c) + 1];
+                    if (cmin == no_point || y_data[cmin] != y_data[cmin])
+                        continue;
+                    if (lo == no_point || y_data[cmin] < y_data[lo])
+                        lo = cmin;
+                    if (hi == no_point || y_data[cmax] > y_data[hi])
+                        hi = cmax;
+                }
+                extrema_data.push_back(lo);
+                extrema_data.push_back(hi);
+            }
+            offset_data.push_back(offset_data.back() + buckets);
+            prev_buckets = buckets;
+        }
+        n_levels = offset_data.size() - 1;
+
+        xp = x_data.data();
+        yp = y_data.data();
+        extrema = extrema_data.data();
+        offsets = offset_data.data();
+    }
+
+    inline void _emit(const uint64_t i, std::vector<double> &xs, std::vector<double> &ys) const
+    {
+        xs.push_back(_x(i));
+        ys.push_back(yp[i]);
+    }
+
+    /**
+     * @brief Appends the points of [lo, hi) with full buckets of `level` and finer ones at both ends
+     */
+    inline void _cover(const uint64_t lo, const uint64_t hi, const uint64_t level, std::vector<double> &xs, std::vector<double> &ys) const
+    {
+        if (lo >= hi)
+            return;
+        if (level == 0)
+        {
+            for (uint64_t i = lo; i < hi; i++)
+                if (yp[i] == yp[i])
+                    _emit(i, xs, ys);
+            return;
+        }
+
+        const uint64_t size = _bucket_size(level);
+        const uint64_t first = (lo + size - 1) / size;
+        // The short last bucket of the series is full when the window reaches the end
+        const uint64_t last = hi == n ? (n + size - 1) / size : hi / size;
+        if (first >= last)
+        {
+            _cover(lo, hi, level - 1, xs, ys);
+            return;
+        }
+
+        _cover(lo, first * size, level - 1, xs, ys);
+        const uint64_t *bucket = extrema + 2 * offsets[level - 1];
+        for (uint64_t b = first; b < last; b++)
+        {
+            const uint64_t i = bucket[2 * b], j = bucket[2 * b + 1];
+            // Empty buckets hold no_point; a corrupt mapped file may hold anything else out of range
+            if (i >= n || j >= n)
+                continue;
+            _emit(std::min(i, j), xs, ys);
+            if (i != j)
+                _emit(std::max(i, j), xs, ys);
+        }
+        _cover(std::min(last * size, n), hi, level - 1, xs, ys);
+    }
+
+public:
+    /**
+     * @brief Builds the index of a series in memory
+     * @tparam T1: type of the x-axis values
+     * @tparam T2: type of the y-axis values
+     * @param x: vector of x-axis values, in increasing order
+     * @param y: vector of y-axis values
+     * @param fanout: number of buckets of a level merged into one bucket of the next level; larger values use less memory but return up to `fanout` buckets per pixel
+     * @note The values are copied; the index does not refer to `x` and `y` afterwards
+     * @overload
+     */
+    template <typename T1, typename T2>
+    inline SeriesIndex(const std::vector<T1> &x, const std::vector<T2> &y, const int fanout = 4)
+        : n(std::min(x.size(), y.size())), fanout(std::max(fanout, 0)), has_x(true)
+    {
+        x_data.assign(x.begin(), x.begin() + n);
+        y_data.assign(y.begin(), y.begin() + n);
+        for (uint64_t i = 1; i < n; i++)
+            if (!(x_data[i] >= x_data[i - 1]))
+                throw std::runtime_error("ERROR: SeriesIndex needs x values in increasing order!");
+        _build();
+    }
+
+    /**
+     * @brief Builds the index of a series in memory, with the indices of the values as x
+     * @tparam T2: type of the y-axis values
+     * @param y: vector of y-axis values
+     * @param fanout: number of buckets of a level merged into one bucket of the next level
+     * @overload
+     */
+    template <typename T2>
+    inline explicit SeriesIndex(const std::vector<T2> &y, const int fanout = 4)
+        : n(y.size()), fanout(std::max(fanout, 0)), has_x(false)
+    {
+        y_data.assign(y.begin(), y.end());
+        _build();
+    }
+
+    /**
+     * @brief Maps an index written by save()
+     * @param path: path of the index file
+     * @note 1. The header and the layout of the levels are checked, so a corrupt file is rejected rather than read out of bounds; the extrema are only read, and checked, by query()
+     * @note 2. `path` is not a string, it is a char array; use string.c_str() to convert a string to char array
+     * @overload
+     */
+    inline explicit SeriesIndex(const char *path)
+    {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("ERROR: Could not open the series index " + std::string(path) + "!");
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header))
+        {
+            close(fd);
+            throw std::runtime_error("ERROR: " + std::string(path) + " is not a series index!");
+        }
+        mapping_size = st.st_size;
+        mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            mapping = nullptr;
+            throw std::runtime_error("ERROR: Could not map the series index " + std::string(path) + "!");
+        }
+
+        const char *base = static_cast<const char *>(mapping);
+        Header header;
+        memcpy(&header, base, sizeof(header));
+        n = header.n;
+        fanout = header.fanout;
+        has_x = header.has_x != 0;
+        n_levels = header.n_levels;
+
+        offsets = reinterpret_cast<const uint64_t *>(base + sizeof(Header));
+        bool valid = memcmp(header.magic, index_magic, 8) == 0 && header.version == index_version && fanout >= 2 && fanout <= 65536 &&
+                     n_levels < 64 && mapping_size >= sizeof(Header) + (n_levels + 1) * sizeof(uint64_t) &&
+                     n <= mapping_size / sizeof(double) && offsets[n_levels] <= mapping_size / (2 * sizeof(uint64_t));
+        const uint64_t points = valid ? (has_x ? 2 : 1) * n : 0;
+        valid = valid && mapping_size == sizeof(Header) + (n_levels + 1 + 2 * offsets[n_levels]) * sizeof(uint64_t) + points * sizeof(double);
+
+        // Each level must hold as many buckets as _build() makes, or queries would read outside the mapping
+        uint64_t buckets = n;
+        valid = valid && offsets[0] == 0;
+        for (uint64_t l = 0; valid && l < n_levels; l++)
+        {
+            valid = buckets > 1 && offsets[l + 1] >= offsets[l] && offsets[l + 1] - offsets[l] == (buckets + fanout - 1) / fanout;
+            buckets = (buckets + fanout - 1) / fanout;
+        }
+        if (!valid)
+        {
+            munmap(mapping, mapping_size);
+            mapping = nullptr;
+            throw std::runtime_error("ERROR: " + std::string(path) + " is not a series index of this version!");
+        }
+        const double *data = reinterpret_cast<const double *>(offsets + n_levels + 1);
+        xp = has_x ? data : nullptr;
+        yp = has_x ? data + n : data;
+        extrema = reinterpret_cast<const uint64_t *>(data + points);
+    }
+
+    SeriesIndex(const SeriesIndex &) = delete;
+    SeriesIndex &operator=(const SeriesIndex &) = delete;
+
+    inline ~SeriesIndex()
+    {
+        if (mapping)
+            munmap(mapping, mapping_size);
+    }
+
+    /**
+     * @brief Writes the series and its pyramid to a file, to be loaded with SeriesIndex(path)
+     * @param path: path of the index file, e.g. next to the data it indexes
+     * @note 1. The index is written to a temporary file next to `path` and renamed over it, so processes that have the old file mapped keep reading it intact
+     * @note 2. `path` is not a string, it is a char array; use string.c_str() to convert a string to char array
+     */
+    inline void save(const char *path) const
+    {
+        const std::string temp = std::string(path) + ".tmp" + std::to_string(getpid());
+        int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        FILE *fout = fd >= 0 ? fdopen(fd, "wb") : nullptr;
+        if (!fout)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+                unlink(temp.c_str());
+            }
+            throw std::runtime_error("ERROR: Could not write the series index " + std::string(path) + "!");
+        }
+
+        Header header;
+        memcpy(header.magic, index_magic, 8);
+        header.version = index_version;
+        header.fanout = static_cast<uint32_t>(fanout);
+        header.n = n;
+        header.has_x = has_x;
+        header.n_levels = n_levels;
+        fwrite(&header, sizeof(header), 1, fout);
+        fwrite(offsets, sizeof(uint64_t), n_levels + 1, fout);
+        if (has_x)
+            fwrite(xp, sizeof(double), n, fout);
+        fwrite(yp, sizeof(double), n, fout);
+        fwrite(extrema, sizeof(uint64_t), 2 * offsets[n_levels], fout);
+        const bool written = !ferror(fout);
+        if (fclose(fout) != 0 || !written || rename(temp.c_str(), path) != 0)
+        {
+            unlink(temp.c_str());
+            throw std::runtime_error("ERROR: Could not write the series index " + std::string(path) + "!");
+        }
+    }
+
+    /**
+     * @brief Returns the points to draw the series between two x values at a given width
+     * @param x_min: lower end of the window
+     * @param x_max: upper end of the window
+     * @param pixels: width of the window in pixels
+     * @param xs: filled with the x values of the points, in increasing order
+     * @param ys: filled with the y values of the points
+     * @note 1. Returns the raw points when the window holds fewer than `fanout` per pixel, otherwise the minimum and maximum of each bucket
+     * @note 2. The nearest point outside each end of the window is included, so that lines reach the borders
+     */
+    inline void query(const double x_min, const double x_max, int pixels, std::vector<double> &xs, std::vector<double> &ys) const
+    {
+        xs.clear();
+        ys.clear();
+        if (n == 0 || !(x_min <= x_max))
+            return;
+        pixels = std::max(pixels, 1);
+
+        uint64_t lo, hi;
+        if (has_x)
+        {
+            lo = std::lower_bound(xp, xp + n, x_min) - xp;
+            hi = std::upper_bound(xp, xp + n, x_max) - xp;
+        }
+        else
+        {
+            lo = static_cast<uint64_t>(std::min(std::max(std::ceil(x_min), 0.0), static_cast<double>(n)));
+            hi = static_cast<uint64_t>(std::min(std::max(std::floor(x_max) + 1.0, 0.0), static_cast<double>(n)));
+        }
+        lo = lo > 0 ? lo - 1 : 0;
+        hi = std::min(n, hi + 1);
+
+        uint64_t level = 0;
+        const uint64_t per_pixel = (hi - lo) / static_cast<uint64_t>(pixels);
+        while (level < n_levels && _bucket_size(level + 1) <= per_pixel)
+            level++;
+
+        xs.reserve(2 * fanout * pixels + 4 * fanout * (level + 1));
+        ys.reserve(xs.capacity());
+        _cover(lo, hi, level, xs, ys);
+    }
+
+    /**
+     * @brief Returns the number of points of the series
+     */
+    inline size_t size() const
+    {
+        return n;
+    }
+
+    /**
+     * @brief Returns the x value of the first point
+     */
+    inline double xMin() const
+    {
+        return n == 0 ? 0.0 : _x(0);
+    }
+
+    /**
+     * @brief Returns the x value of the last point
+     */
+    inline double xMax() const
+    {
+        return n == 0 ? 0.0 : _x(n - 1);
+    }
+};